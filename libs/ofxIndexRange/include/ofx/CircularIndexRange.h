@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include <iostream>
+#include "ofx/IndexRange.h"
+
+
+namespace ofx {
+
+
+/// \brief An index range that wraps around modulo a capacity.
+///
+/// This describes a region of a ring buffer. Unlike IndexRange, a range that
+/// runs past the end of the buffer is not an overflow. It continues at index
+/// 0 and is accessed as two contiguous spans, first() and second(), which can
+/// be passed directly to memcpy() or writev() without copying:
+///
+///     IndexRange a = range.first();
+///     IndexRange b = range.second();
+///     std::memcpy(output, ring + a.location, a.size);
+///     std::memcpy(output + a.size, ring + b.location, b.size);
+///
+/// The location is always less than the capacity and the size is never
+/// larger than the capacity.
+class CircularIndexRange
+{
+public:
+    /// \brief Create an empty range with a capacity of 0.
+    CircularIndexRange();
+
+    /// \brief Create a circular range.
+    ///
+    /// The location is wrapped and the size is clamped to the capacity.
+    ///
+    /// \param location The starting location, wrapped modulo capacity.
+    /// \param size The number of indices.
+    /// \param capacity The ring capacity.
+    CircularIndexRange(std::size_t location,
+                       std::size_t size,
+                       std::size_t capacity);
+
+    /// \returns true if the size is 0.
+    bool empty() const;
+
+    /// \returns true if the range runs past the end of the ring.
+    bool wraps() const;
+
+    /// \returns the index after the last index, wrapped modulo capacity.
+    std::size_t getMax() const;
+
+    /// \brief Determine if the range contains an index.
+    /// \param index The index to test, wrapped modulo capacity.
+    /// \returns true if the index is in the range.
+    bool contains(std::size_t index) const;
+
+    /// \returns the number of contiguous spans, 0, 1 or 2.
+    std::size_t numSpans() const;
+
+    /// \returns the span from location up to the end of the ring or range.
+    IndexRange first() const;
+
+    /// \returns the wrapped span starting at 0, or an empty range.
+    IndexRange second() const;
+
+    bool operator == (const CircularIndexRange& other) const;
+    bool operator != (const CircularIndexRange& other) const;
+
+    /// \brief The starting location of the range, less than capacity.
+    std::size_t location = 0;
+
+    /// \brief The size of the range, not larger than capacity.
+    std::size_t size = 0;
+
+    /// \brief The ring capacity.
+    std::size_t capacity = 0;
+
+    friend std::ostream& operator << (std::ostream& os, const CircularIndexRange& range);
+
+};
+
+
+inline std::ostream& operator << (std::ostream& os, const CircularIndexRange& range)
+{
+    os << "{" << range.location << "," << range.size << "," << range.capacity << "}";
+    return os;
+}
+
+
+} // namespace ofx
@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include "ofx/CircularIndexRange.h"
+#include "ofx/IndexRangeList.h"
+
+
+namespace ofx {
+
+
+/// \brief A sorted, merged list of circular ranges in a ring of fixed capacity.
+///
+/// Coverage that runs across the end of the ring is stored as a single range
+/// rather than being split at the wrap, so a ring buffer that keeps wrapping
+/// does not accumulate extra ranges. Internally, at most one stored range
+/// extends past the capacity. Its wrapped part absorbs any ranges at the
+/// start of the ring that it touches.
+class CircularIndexRangeList
+{
+public:
+    /// \brief Create an empty list with a capacity of 0.
+    CircularIndexRangeList();
+
+    /// \brief Create an empty list for a ring of the given capacity.
+    ///
+    /// The capacity is clamped to IndexRange::MAX / 2.
+    ///
+    /// \param capacity The ring capacity.
+    CircularIndexRangeList(std::size_t capacity);
+
+    /// \brief Add a range, wrapped modulo the capacity of this list.
+    /// \param range The range to add.
+    void add(const CircularIndexRange& range);
+
+    /// \brief Remove a range, wrapped modulo the capacity of this list.
+    /// \param range The range to remove.
+    void remove(const CircularIndexRange& range);
+
+    /// \brief Remove all ranges.
+    void clear();
+
+    /// \returns true if there are no ranges.
+    bool empty() const;
+
+    /// \returns the number of ranges.
+    std::size_t size() const;
+
+    /// \returns the ring capacity.
+    std::size_t capacity() const;
+
+    /// \returns the number of covered indices.
+    std::size_t cardinality() const;
+
+    /// \brief Determine if an index is covered.
+    /// \param index The index to test, wrapped modulo capacity.
+    /// \returns true if the index is covered.
+    bool contains(std::size_t index) const;
+
+    /// \brief Get the covered ranges.
+    ///
+    /// Ranges are sorted by location. At most one range wraps, and it is
+    /// returned last.
+    ///
+    /// \returns the circular ranges.
+    std::vector<CircularIndexRange> ranges() const;
+
+private:
+    /// \brief Map a range into the unwrapped coordinates of _list.
+    IndexRange _unwrap(const CircularIndexRange& range) const;
+
+    /// \brief Restore the single wrapped range invariant.
+    void _normalize();
+
+    /// \brief The ring capacity.
+    std::size_t _capacity = 0;
+
+    /// \brief The ranges in unwrapped coordinates, all below 2 * _capacity.
+    IndexRangeList _list;
+
+};
+
+
+} // namespace ofx
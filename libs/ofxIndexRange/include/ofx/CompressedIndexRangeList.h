@@ -0,0 +1,168 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "ofx/IndexRangeList.h"
+
+
+namespace ofx {
+
+
+/// \brief A compact, read-mostly list of sorted, merged ranges.
+///
+/// Ranges are stored in blocks of BLOCK_SIZE. Within a block, each range is
+/// encoded as the gap from the end of the previous range and its size - 1,
+/// and both are bit-packed with the smallest width that fits the block. The
+/// location of the first range of each block is kept in a small skip index.
+///
+/// Queries binary search the skip index and decode only the blocks they
+/// touch. Set operations stream over both inputs one decoded block at a
+/// time, so neither input is expanded in full.
+///
+/// Ranges are appended in order. Until a block is full, its ranges are kept
+/// uncompressed.
+class CompressedIndexRangeList
+{
+public:
+    /// \brief The number of ranges in a block.
+    static const std::size_t BLOCK_SIZE = 128;
+
+    /// \brief Create an empty list.
+    CompressedIndexRangeList();
+
+    /// \brief Create a compressed copy of a list.
+    /// \param list The list to compress.
+    CompressedIndexRangeList(const IndexRangeList& list);
+
+    /// \brief Append a range.
+    ///
+    /// The range is validated. A range that overlaps or touches the last
+    /// range is merged with it.
+    ///
+    /// \param range The range to append.
+    /// \returns false if the range starts before the last range.
+    bool append(const IndexRange& range);
+
+    /// \brief Remove all ranges.
+    void clear();
+
+    /// \returns true if there are no ranges.
+    bool empty() const;
+
+    /// \returns the number of ranges.
+    std::size_t size() const;
+
+    /// \returns the number of covered indices.
+    std::size_t cardinality() const;
+
+    /// \returns the number of compressed blocks.
+    std::size_t numBlocks() const;
+
+    /// \brief Determine if an index is covered.
+    /// \param index The index to test.
+    /// \returns true if the index is covered.
+    bool contains(std::size_t index) const;
+
+    /// \brief Find the first range that ends after an index.
+    /// \param index The index to search for.
+    /// \returns the range containing the index, the first range after it, or
+    ///          an empty range at IndexRange::MAX if there is none.
+    IndexRange lowerBound(std::size_t index) const;
+
+    /// \brief Call a function for each range, in order.
+    /// \param function The function to call.
+    void forEach(const std::function<void(const IndexRange&)>& function) const;
+
+    /// \returns the decoded ranges.
+    std::vector<IndexRange> ranges() const;
+
+    /// \returns the decoded ranges as an IndexRangeList.
+    IndexRangeList toList() const;
+
+    /// \brief Determine the union of this list and the other.
+    /// \param other The other list.
+    /// \returns a list covering the indices covered by either list.
+    CompressedIndexRangeList unionWith(const CompressedIndexRangeList& other) const;
+
+    /// \brief Determine the intersection of this list and the other.
+    /// \param other The other list.
+    /// \returns a list covering the indices covered by both lists.
+    CompressedIndexRangeList intersectionWith(const CompressedIndexRangeList& other) const;
+
+    /// \brief Determine the difference of this list and the other.
+    /// \param other The other list.
+    /// \returns a list covering the indices covered by this list but not the other.
+    CompressedIndexRangeList differenceWith(const CompressedIndexRangeList& other) const;
+
+    /// \returns true if both lists have the same ranges.
+    bool operator == (const CompressedIndexRangeList& other) const;
+    bool operator != (const CompressedIndexRangeList& other) const;
+
+    /// \returns the approximate number of bytes used.
+    std::size_t sizeInBytes() const;
+
+private:
+    /// \brief Reads the ranges in order, one decoded block at a time.
+    class Cursor;
+
+    /// \brief A compressed block.
+    struct Block
+    {
+        /// \brief The first word of the block in _words.
+        std::size_t wordOffset = 0;
+
+        /// \brief The number of ranges.
+        uint16_t count = 0;
+
+        /// \brief The bits per gap.
+        uint8_t gapBits = 0;
+
+        /// \brief The bits per size - 1.
+        uint8_t sizeBits = 0;
+    };
+
+    /// \brief Compress _tail into a new block.
+    void _seal();
+
+    /// \returns the number of blocks, including the uncompressed tail.
+    std::size_t _numDecodable() const;
+
+    /// \brief Decode a block, or the tail if block == _blocks.size().
+    /// \returns the number of decoded ranges.
+    std::size_t _decode(std::size_t block, IndexRange* output) const;
+
+    /// \returns the block whose first range is the last starting at or
+    ///          before index, or _numDecodable() if there is none.
+    std::size_t _findBlock(std::size_t index) const;
+
+    /// \brief The compressed blocks.
+    std::vector<Block> _blocks;
+
+    /// \brief The location of the first range of each block.
+    std::vector<std::size_t> _starts;
+
+    /// \brief The packed gaps and sizes of all blocks.
+    std::vector<uint64_t> _words;
+
+    /// \brief The ranges not yet compressed, at most BLOCK_SIZE.
+    std::vector<IndexRange> _tail;
+
+    /// \brief The number of ranges.
+    std::size_t _size = 0;
+
+    /// \brief The number of covered indices.
+    std::size_t _cardinality = 0;
+
+};
+
+
+} // namespace ofx
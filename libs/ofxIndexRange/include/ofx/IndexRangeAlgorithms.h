@@ -0,0 +1,207 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "ofx/IndexRangeList.h"
+
+
+namespace ofx {
+
+
+/// \brief Copy and erase the elements of contiguous storage selected by an
+/// IndexRangeList.
+///
+/// Elements are moved one run at a time. Trivially copyable types are moved
+/// with a single memcpy() or memmove() per run, other types with std::copy()
+/// or std::move().
+///
+/// The ranges are read in place, without a copy, from a list with any
+/// overflow policy. Ranges that extend past the end of the storage are
+/// clipped.
+class IndexRangeAlgorithms
+{
+public:
+    /// \brief Copy the selected elements into packed output.
+    /// \param list The selected indices.
+    /// \param input The input elements.
+    /// \param size The number of input elements.
+    /// \param output The output, with room for list.cardinality() elements.
+    /// \returns the number of elements copied.
+    template <typename T, typename OverflowPolicy>
+    static std::size_t gather(const IndexRangeList_<OverflowPolicy>& list,
+                              const T* input,
+                              std::size_t size,
+                              T* output)
+    {
+        std::size_t count = 0;
+
+        for (auto& range: list)
+        {
+            if (range.location >= size)
+                break;
+
+            std::size_t n = std::min(range.size, size - range.location);
+            _copy(input + range.location, n, output + count, std::is_trivially_copyable<T>());
+            count += n;
+        }
+
+        return count;
+    }
+
+    /// \brief Copy the selected elements into a new vector.
+    /// \param list The selected indices.
+    /// \param input The input elements.
+    /// \returns the selected elements in order.
+    template <typename T, typename OverflowPolicy>
+    static std::vector<T> gather(const IndexRangeList_<OverflowPolicy>& list,
+                                 const std::vector<T>& input)
+    {
+        std::vector<T> output(std::min(list.cardinality(), input.size()));
+        output.resize(gather(list, input.data(), input.size(), output.data()));
+        return output;
+    }
+
+    /// \brief Copy packed elements back to the selected indices.
+    ///
+    /// This is the inverse of gather().
+    ///
+    /// \param list The selected indices.
+    /// \param input The packed elements, at least list.cardinality().
+    /// \param output The output elements.
+    /// \param size The number of output elements.
+    /// \returns the number of elements copied.
+    template <typename T, typename OverflowPolicy>
+    static std::size_t scatter(const IndexRangeList_<OverflowPolicy>& list,
+                               const T* input,
+                               T* output,
+                               std::size_t size)
+    {
+        std::size_t count = 0;
+
+        for (auto& range: list)
+        {
+            if (range.location >= size)
+                break;
+
+            std::size_t n = std::min(range.size, size - range.location);
+            _copy(input + count, n, output + range.location, std::is_trivially_copyable<T>());
+            count += n;
+        }
+
+        return count;
+    }
+
+    /// \brief Copy packed elements back to the selected indices.
+    /// \param list The selected indices.
+    /// \param input The packed elements.
+    /// \param output The output elements.
+    /// \returns the number of elements copied.
+    template <typename T, typename OverflowPolicy>
+    static std::size_t scatter(const IndexRangeList_<OverflowPolicy>& list,
+                               const std::vector<T>& input,
+                               std::vector<T>& output)
+    {
+        std::size_t count = 0;
+
+        for (auto& range: list)
+        {
+            // Never read past the end of the packed input.
+            if (range.location >= output.size() || count >= input.size())
+                break;
+
+            std::size_t n = std::min({ range.size,
+                                       output.size() - range.location,
+                                       input.size() - count });
+            _copy(input.data() + count, n, output.data() + range.location, std::is_trivially_copyable<T>());
+            count += n;
+        }
+
+        return count;
+    }
+
+    /// \brief Erase the selected elements in a single pass.
+    ///
+    /// The remaining elements keep their order and are moved to the front.
+    /// Elements after the returned size are left in a valid but unspecified
+    /// state.
+    ///
+    /// \param list The indices to erase.
+    /// \param data The elements.
+    /// \param size The number of elements.
+    /// \returns the number of remaining elements.
+    template <typename T, typename OverflowPolicy>
+    static std::size_t compactErase(const IndexRangeList_<OverflowPolicy>& list,
+                                    T* data,
+                                    std::size_t size)
+    {
+        std::size_t write = 0;
+        std::size_t read = 0;
+
+        for (auto& range: list)
+        {
+            if (range.location >= size)
+                break;
+
+            _move(data + read, range.location - read, data + write, std::is_trivially_copyable<T>());
+            write += range.location - read;
+            read = std::min(range.getMax(), size);
+        }
+
+        _move(data + read, size - read, data + write, std::is_trivially_copyable<T>());
+        return write + size - read;
+    }
+
+    /// \brief Erase the selected elements of a vector in a single pass.
+    /// \param list The indices to erase.
+    /// \param data The elements.
+    template <typename T, typename OverflowPolicy>
+    static void compactErase(const IndexRangeList_<OverflowPolicy>& list, std::vector<T>& data)
+    {
+        std::size_t size = compactErase(list, data.data(), data.size());
+        data.erase(data.begin() + size, data.end());
+    }
+
+private:
+    /// \brief Copy non-overlapping elements.
+    template <typename T>
+    static void _copy(const T* first, std::size_t count, T* output, std::true_type)
+    {
+        if (count > 0)
+            std::memcpy(output, first, count * sizeof(T));
+    }
+
+    template <typename T>
+    static void _copy(const T* first, std::size_t count, T* output, std::false_type)
+    {
+        std::copy(first, first + count, output);
+    }
+
+    /// \brief Move elements towards the front, possibly overlapping.
+    template <typename T>
+    static void _move(T* first, std::size_t count, T* output, std::true_type)
+    {
+        if (count > 0 && first != output)
+            std::memmove(output, first, count * sizeof(T));
+    }
+
+    template <typename T>
+    static void _move(T* first, std::size_t count, T* output, std::false_type)
+    {
+        if (first != output)
+            std::move(first, first + count, output);
+    }
+
+};
+
+
+} // namespace ofx
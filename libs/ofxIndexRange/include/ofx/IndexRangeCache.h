@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <vector>
+#include "ofx/IndexRangeList.h"
+
+
+namespace ofx {
+
+
+/// \brief A cached span returned by IndexRangeCache::lookup().
+struct IndexRangeCachePiece
+{
+    /// \brief The byte range of the span.
+    IndexRange range;
+
+    /// \brief The cached bytes, valid until the cache is next modified.
+    const uint8_t* data = nullptr;
+
+};
+
+
+/// \brief The result of IndexRangeCache::lookup().
+struct IndexRangeCacheLookup
+{
+    /// \brief The cached spans of the requested range, sorted by location.
+    std::vector<IndexRangeCachePiece> pieces;
+
+    /// \brief The parts of the requested range that are not cached.
+    IndexRangeList missing;
+
+};
+
+
+/// \brief A size-bounded cache of bytes keyed by byte range.
+///
+/// Cached data is stored as disjoint chunks sorted by location. Inserting a
+/// chunk replaces any cached bytes it overlaps and merges it with the chunks
+/// it touches, so sequential inserts build a single contiguous chunk.
+///
+/// When the cache holds more than its capacity, the least recently used
+/// chunks are evicted. Looking up a range marks the chunks it touches as
+/// used.
+class IndexRangeCache
+{
+public:
+    /// \brief Create a cache with an unbounded capacity.
+    IndexRangeCache();
+
+    /// \brief Create a cache with the given capacity.
+    /// \param capacity The maximum number of cached bytes.
+    IndexRangeCache(std::size_t capacity);
+
+    /// \brief Insert a chunk of bytes.
+    ///
+    /// If the chunk is larger than the capacity, only its first capacity bytes
+    /// are cached. When merging the chunk with its neighbours would exceed the
+    /// capacity, the neighbouring bytes are trimmed first.
+    ///
+    /// \param location The byte offset of the chunk.
+    /// \param data The bytes to cache.
+    /// \param size The number of bytes to cache.
+    void insert(std::size_t location, const uint8_t* data, std::size_t size);
+
+    /// \brief Insert a chunk of bytes.
+    /// \param location The byte offset of the chunk.
+    /// \param data The bytes to cache.
+    void insert(std::size_t location, const std::vector<uint8_t>& data);
+
+    /// \brief Find the cached and missing parts of a byte range.
+    ///
+    /// This runs in O(log n + k) for n cached chunks, k of which overlap the
+    /// range.
+    ///
+    /// \param range The byte range to look up.
+    /// \returns the cached pieces and the missing ranges.
+    IndexRangeCacheLookup lookup(const IndexRange& range);
+
+    /// \brief Remove the cached bytes in a range, splitting chunks as needed.
+    /// \param range The byte range to remove.
+    void erase(const IndexRange& range);
+
+    /// \brief Remove all cached bytes.
+    void clear();
+
+    /// \returns true if nothing is cached.
+    bool empty() const;
+
+    /// \returns the number of cached bytes.
+    std::size_t size() const;
+
+    /// \returns the number of cached chunks.
+    std::size_t numChunks() const;
+
+    /// \returns the maximum number of cached bytes.
+    std::size_t capacity() const;
+
+    /// \brief Set the maximum number of cached bytes, evicting if needed.
+    /// \param capacity The maximum number of cached bytes.
+    void setCapacity(std::size_t capacity);
+
+    /// \returns the cached byte ranges.
+    IndexRangeList cached() const;
+
+private:
+    /// \brief A cached chunk.
+    struct Chunk
+    {
+        /// \brief The cached bytes.
+        std::vector<uint8_t> data;
+
+        /// \brief The position of this chunk in _lru.
+        std::list<std::size_t>::iterator lru;
+    };
+
+    typedef std::map<std::size_t, Chunk> ChunkMap;
+
+    /// \returns the first chunk that ends after location.
+    ChunkMap::iterator _firstEndingAfter(std::size_t location);
+
+    /// \brief Mark a chunk as the most recently used.
+    void _touch(ChunkMap::iterator chunk);
+
+    /// \brief Remove a chunk.
+    ChunkMap::iterator _remove(ChunkMap::iterator chunk);
+
+    /// \brief Evict the least recently used chunks, other than keep, until
+    ///        the cache fits its capacity.
+    void _evict(std::size_t keep);
+
+    /// \brief The maximum number of cached bytes.
+    std::size_t _capacity = IndexRange::MAX;
+
+    /// \brief The number of cached bytes.
+    std::size_t _size = 0;
+
+    /// \brief The chunks, keyed by location.
+    ChunkMap _chunks;
+
+    /// \brief The chunk locations, most recently used first.
+    std::list<std::size_t> _lru;
+
+};
+
+
+} // namespace ofx
@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include "ofx/IndexRangeList.h"
+
+
+namespace ofx {
+
+
+/// \brief Settings for IndexRangeDirtyTracker.
+struct IndexRangeDirtyTrackerSettings
+{
+    /// \brief Dirty ranges are expanded to multiples of this size.
+    ///
+    /// This is usually a page size or the granule size of the destination.
+    /// A value of 0 or 1 disables snapping.
+    std::size_t granularity = 4096;
+
+    /// \brief The fixed cost of issuing one extra copy, measured in bytes.
+    ///
+    /// Two dirty spans separated by a gap of up to this many clean bytes are
+    /// copied as one span, because copying the gap is cheaper than the
+    /// overhead of another copy.
+    std::size_t copyOverhead = 256;
+
+};
+
+
+/// \brief Track the modified regions of a buffer and copy them on demand.
+///
+/// Modified byte ranges are snapped to the configured granularity and merged
+/// as they are added. When the buffer is flushed, nearby dirty spans are
+/// merged according to a simple cost model and only the resulting spans are
+/// copied.
+class IndexRangeDirtyTracker
+{
+public:
+    typedef IndexRangeDirtyTrackerSettings Settings;
+
+    /// \brief Create a dirty tracker with the default settings.
+    IndexRangeDirtyTracker();
+
+    /// \brief Create a dirty tracker with the given settings.
+    /// \param settings The settings to use.
+    IndexRangeDirtyTracker(const Settings& settings);
+
+    /// \brief Mark the given byte range as modified.
+    /// \param range The modified range.
+    void add(const IndexRange& range);
+
+    /// \brief Mark the whole buffer as clean.
+    void clear();
+
+    /// \returns true if nothing is dirty.
+    bool empty() const;
+
+    /// \returns the number of dirty bytes, after snapping.
+    std::size_t dirtyBytes() const;
+
+    /// \returns the snapped dirty ranges.
+    const IndexRangeList& dirty() const;
+
+    /// \returns the settings.
+    const Settings& settings() const;
+
+    /// \brief Get the spans that a flush would copy.
+    /// \param size The size of the buffer. Spans are clipped to this size.
+    /// \returns the sorted spans to copy.
+    std::vector<IndexRange> plan(std::size_t size) const;
+
+    /// \brief Copy the dirty spans from \p source to \p destination and clear.
+    ///
+    /// Both buffers must be at least \p size bytes and must not overlap.
+    ///
+    /// \param source The modified buffer.
+    /// \param destination The buffer to update.
+    /// \param size The size of both buffers.
+    /// \returns the number of bytes copied.
+    std::size_t flush(const void* source, void* destination, std::size_t size);
+
+private:
+    /// \brief The settings.
+    Settings _settings;
+
+    /// \brief The snapped dirty ranges.
+    IndexRangeList _dirty;
+
+};
+
+
+} // namespace ofx
@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include "ofx/IndexRange.h"
+
+
+namespace ofx {
+
+
+/// \brief An insert or erase of a range of indices.
+///
+/// Edits describe the same operations as IndexRangeList::insert() and
+/// IndexRangeList::erase() and can be applied in batches with
+/// IndexRangeList::apply().
+class IndexRangeEdit
+{
+public:
+    /// \brief The kind of edit.
+    enum class Type
+    {
+        /// \brief Insert range.size indices at range.location.
+        INSERT,
+        /// \brief Erase the indices in range.
+        ERASE
+    };
+
+    /// \brief Create an empty insert.
+    IndexRangeEdit();
+
+    /// \brief Create an edit.
+    /// \param type The kind of edit.
+    /// \param range The inserted or erased range.
+    IndexRangeEdit(Type type, const IndexRange& range);
+
+    bool operator == (const IndexRangeEdit& other) const;
+    bool operator != (const IndexRangeEdit& other) const;
+
+    /// \brief Create an insert edit.
+    /// \param range The inserted range.
+    /// \returns the edit.
+    static IndexRangeEdit insert(const IndexRange& range);
+
+    /// \brief Create an erase edit.
+    /// \param range The erased range.
+    /// \returns the edit.
+    static IndexRangeEdit erase(const IndexRange& range);
+
+    /// \brief The kind of edit.
+    Type type = Type::INSERT;
+
+    /// \brief The inserted or erased range.
+    IndexRange range;
+
+};
+
+
+} // namespace ofx
@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include <cstdint>
+#include <string>
+#include "ofx/IndexRangeList.h"
+
+
+namespace ofx {
+
+
+/// \brief Settings for IndexRangeFileReader.
+struct IndexRangeFileReaderSettings
+{
+    /// \brief The settings used to coalesce the ranges into requests.
+    IndexRangeCoalesceSettings coalesce;
+
+    /// \brief The number of threads used to issue requests.
+    ///
+    /// Requests are issued on the IndexRangeParallel thread pool, so at most
+    /// IndexRangeParallel::numThreads() threads are used. A value of 0 uses
+    /// IndexRangeParallel::numThreads(). Ignored on platforms without
+    /// positional reads.
+    std::size_t numThreads = 1;
+
+};
+
+
+/// \brief Read the byte ranges described by an IndexRangeList from a file.
+///
+/// The ranges are first coalesced into larger requests with
+/// IndexRangeList::coalesce(). Each request is then read with a single
+/// vectored read (preadv on POSIX systems) that scatters the wanted bytes
+/// directly into the caller's buffers. Bytes in the holes between ranges are
+/// read into a per-thread scratch buffer and discarded, so no data is copied
+/// after it is read. Where preadv is unavailable, e.g. before macOS 11 and
+/// iOS 14, each range is read with its own pread and the holes are skipped.
+///
+/// Lists with bytes past the largest file offset (off_t) are rejected.
+///
+/// Requests can optionally be issued from several threads of the
+/// IndexRangeParallel pool.
+class IndexRangeFileReader
+{
+public:
+    typedef IndexRangeFileReaderSettings Settings;
+
+    /// \brief Read the covered bytes into a contiguous buffer.
+    ///
+    /// The bytes of each range are packed in order, so the byte at index i of
+    /// the file is written to output[list.rank(i)].
+    ///
+    /// \param fd An open file descriptor.
+    /// \param list The byte ranges to read.
+    /// \param output A buffer of at least list.cardinality() bytes.
+    /// \param settings The read settings.
+    /// \returns true if all bytes were read.
+    static bool read(int fd,
+                     const IndexRangeList& list,
+                     uint8_t* output,
+                     const Settings& settings = Settings());
+
+    /// \brief Read each range into its own buffer.
+    ///
+    /// \param fd An open file descriptor.
+    /// \param list The byte ranges to read.
+    /// \param buffers One buffer per range in list.ranges(), each at least as
+    ///        large as its range.
+    /// \param settings The read settings.
+    /// \returns true if all bytes were read.
+    static bool read(int fd,
+                     const IndexRangeList& list,
+                     const std::vector<uint8_t*>& buffers,
+                     const Settings& settings = Settings());
+
+    /// \brief Read the covered bytes of a file into a contiguous buffer.
+    ///
+    /// \param path The path of the file to read.
+    /// \param list The byte ranges to read.
+    /// \param output The output is resized to list.cardinality() bytes.
+    /// \param settings The read settings.
+    /// \returns true if all bytes were read.
+    static bool read(const std::string& path,
+                     const IndexRangeList& list,
+                     std::vector<uint8_t>& output,
+                     const Settings& settings = Settings());
+
+};
+
+
+} // namespace ofx
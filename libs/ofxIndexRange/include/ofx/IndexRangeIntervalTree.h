@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include <functional>
+#include <utility>
+#include <vector>
+#include "ofx/IndexRange.h"
+
+
+namespace ofx {
+
+
+/// \brief A range tagged with a user ID.
+struct IndexRangeInterval
+{
+    /// \brief The range.
+    IndexRange range;
+
+    /// \brief The user ID.
+    std::size_t id = 0;
+
+};
+
+
+/// \brief A container of unmerged, ID-tagged ranges with overlap queries.
+///
+/// Unlike IndexRangeList, ranges are never merged, so queries report which
+/// of the original ranges overlap.
+///
+/// The intervals are stored in a single array sorted by location, laid out
+/// as an implicit balanced binary tree: the root is at index 2^K - 1 and the
+/// children of the node at index x and level k are at x -/+ 2^(k-1). Each
+/// node also stores the largest end in its subtree, so subtrees that end
+/// before a query are skipped. A query visits O(log n + k log(n / k)) nodes
+/// for k results and scans small subtrees linearly.
+///
+/// The index is built lazily by the first query after a change, in
+/// O(n log n). Empty ranges are stored but never overlap anything.
+class IndexRangeIntervalTree
+{
+public:
+    /// \brief Create an empty tree.
+    IndexRangeIntervalTree();
+
+    /// \brief Add a range.
+    /// \param range The range to add. It is validated, but not merged.
+    /// \param id The user ID reported with the range.
+    void add(const IndexRange& range, std::size_t id);
+
+    /// \brief Remove all ranges with an ID.
+    /// \param id The ID to remove.
+    /// \returns the number of ranges removed.
+    std::size_t remove(std::size_t id);
+
+    /// \brief Remove all ranges.
+    void clear();
+
+    /// \returns true if there are no ranges.
+    bool empty() const;
+
+    /// \returns the number of ranges.
+    std::size_t size() const;
+
+    /// \returns all intervals, sorted by location, end and ID.
+    std::vector<IndexRangeInterval> intervals() const;
+
+    /// \brief Find the intervals that contain an index.
+    /// \param index The index to query.
+    /// \returns the intervals that contain the index, sorted by location.
+    std::vector<IndexRangeInterval> stab(std::size_t index) const;
+
+    /// \brief Find the intervals that overlap a range.
+    /// \param range The range to query.
+    /// \returns the overlapping intervals, sorted by location.
+    std::vector<IndexRangeInterval> overlapping(const IndexRange& range) const;
+
+    /// \brief Call a function for each interval that overlaps a range.
+    /// \param range The range to query.
+    /// \param function Called in order of location.
+    void forEachOverlapping(const IndexRange& range,
+                            const std::function<void(const IndexRangeInterval&)>& function) const;
+
+    /// \brief Find all overlapping pairs between this tree and the other.
+    ///
+    /// Both trees are swept once in order of location, keeping the intervals
+    /// that are still open on each side. This runs in O(n + m + k) for k
+    /// pairs once both trees are indexed.
+    ///
+    /// \param other The other tree.
+    /// \param function Called with each pair, the interval from this tree
+    ///        first.
+    void join(const IndexRangeIntervalTree& other,
+              const std::function<void(const IndexRangeInterval&, const IndexRangeInterval&)>& function) const;
+
+    /// \brief Find the IDs of all overlapping pairs.
+    /// \param other The other tree.
+    /// \returns pairs of IDs, the ID from this tree first.
+    std::vector<std::pair<std::size_t, std::size_t>> join(const IndexRangeIntervalTree& other) const;
+
+private:
+    /// \brief An interval and the largest end in its subtree.
+    struct Node
+    {
+        IndexRangeInterval interval;
+        std::size_t maxEnd = 0;
+    };
+
+    /// \brief Will sort _nodes and update the subtree ends if needed.
+    void _index() const;
+
+    /// \brief Compute the subtree ends, returning the end of the subtree.
+    std::size_t _build(std::size_t x, std::size_t level) const;
+
+    /// \brief Report the intervals of a subtree that overlap [min, max).
+    void _query(std::size_t x,
+                std::size_t level,
+                std::size_t min,
+                std::size_t max,
+                const std::function<void(const IndexRangeInterval&)>& function) const;
+
+    /// \brief The nodes in sorted order.
+    mutable std::vector<Node> _nodes;
+
+    /// \brief True if _nodes is sorted and indexed.
+    mutable bool _indexed = true;
+
+    /// \brief The level of the root node.
+    mutable std::size_t _rootLevel = 0;
+
+};
+
+
+} // namespace ofx
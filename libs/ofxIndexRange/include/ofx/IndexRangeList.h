@@ -8,27 +8,148 @@
 #pragma once
 
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
 #include "ofx/IndexRange.h"
+#include "ofx/IndexRangeEdit.h"
+#include "ofx/IndexRangeVector.h"
 
 
 namespace ofx {
 
 
+class IndexRangeMapper;
+
+
+/// \brief Settings for IndexRangeList::coalesce().
+struct IndexRangeCoalesceSettings
+{
+    /// \brief The largest gap between two ranges that will be merged.
+    ///
+    /// A value of 0 only merges ranges that become adjacent or overlap after
+    /// alignment.
+    std::size_t maxGap = 0;
+
+    /// \brief Merged ranges are expanded to multiples of this block size.
+    ///
+    /// A value of 0 or 1 disables alignment.
+    std::size_t alignment = 1;
+
+    /// \brief The maximum size of a merged range.
+    ///
+    /// Ranges larger than this are split. When aligning, the effective
+    /// maximum is rounded down to a multiple of the alignment, but is never
+    /// smaller than the alignment.
+    std::size_t maxSize = IndexRange::MAX;
+
+};
+
+
+/// \brief A merged range and the original ranges that it covers.
+struct IndexRangeRequest
+{
+    /// \brief The merged, possibly aligned, range.
+    IndexRange range;
+
+    /// \brief The sorted original ranges inside of the merged range.
+    std::vector<IndexRange> ranges;
+
+};
+
+
+/// \brief The default overflow policy, which clamps ranges to IndexRange::MAX.
+///
+/// Ranges that overflow are truncated with IndexRange::clearOverflow(), and
+/// ranges that insert() shifts past the end are truncated or removed.
+struct IndexRangeClampPolicy
+{
+    /// \brief True if ranges are checked for overflow.
+    static const bool CHECK = true;
+
+    /// \brief Called before an operation that would overflow.
+    ///
+    /// Returning continues the operation with clamped ranges.
+    static void overflow(const IndexRange&)
+    {
+    }
+
+};
+
+
+/// \brief An overflow policy that rejects ranges that overflow.
+struct IndexRangeCheckedPolicy
+{
+    /// \brief True if ranges are checked for overflow.
+    static const bool CHECK = true;
+
+    /// \brief Called before an operation that would overflow.
+    /// \param range The range that overflows, or a range of the list that an
+    ///        edit would move past the end.
+    /// \throws std::overflow_error
+    static void overflow(const IndexRange& range)
+    {
+        throw std::overflow_error("IndexRange {" + std::to_string(range.location)
+                                  + "," + std::to_string(range.size)
+                                  + "} overflows.");
+    }
+
+};
+
+
+/// \brief An overflow policy for trusted producers of well formed ranges.
+///
+/// No checks are made. The caller guarantees that no range overflows and
+/// that insert() never shifts a range past IndexRange::MAX.
+struct IndexRangeUncheckedPolicy
+{
+    /// \brief True if ranges are checked for overflow.
+    static const bool CHECK = false;
+
+    /// \brief Never called.
+    static void overflow(const IndexRange&)
+    {
+    }
+
+};
+
+
 /// \brief A list for working with collections of index ranges.
 ///
 /// Ranges can be added, removed, inserted and erased.
-class IndexRangeList
+///
+/// The OverflowPolicy decides what happens to ranges that run past
+/// IndexRange::MAX. IndexRangeList uses IndexRangeClampPolicy. Lists using
+/// IndexRangeUncheckedPolicy skip the checks in every mutator.
+template <typename OverflowPolicy>
+class IndexRangeList_
 {
 public:
     /// \brief Create a default empty IndexRangeList.
-    IndexRangeList();
+    IndexRangeList_();
 
     /// \brief Create an IndexRangeList with the given ranges.
     /// \param ranges The ranges to add.
-    IndexRangeList(const std::vector<IndexRange>& ranges);
+    IndexRangeList_(const std::vector<IndexRange>& ranges);
+
+    /// \brief Copy an IndexRangeList.
+    ///
+    /// The index used by rank() and select() is not copied, and is rebuilt
+    /// on demand.
+    ///
+    /// \param other The list to copy.
+    IndexRangeList_(const IndexRangeList_& other);
+
+    /// \brief Move an IndexRangeList, leaving the other list empty.
+    /// \param other The list to move.
+    IndexRangeList_(IndexRangeList_&& other) noexcept;
 
     /// \brief Destroy the IndexRangeList.
-    ~IndexRangeList();
+    ~IndexRangeList_();
+
+    IndexRangeList_& operator = (const IndexRangeList_& other);
+    IndexRangeList_& operator = (IndexRangeList_&& other) noexcept;
 
     /// \brief Add the given range to the list.
     ///
@@ -39,14 +160,23 @@ public:
     /// \param range The range to add.
     void add(const IndexRange& range);
 
-    /// \brief Add the given range to the list.
+    /// \brief Add all ranges of another list to this list.
+    /// \param other The list to add.
+    void add(const IndexRangeList_& other);
+
+    /// \brief Remove the given range from the list.
     ///
     /// If the removed range overlaps with an existing range all
-    /// intersecting portions will be removed.
+    /// intersecting portions will be removed. The intersecting ranges are
+    /// found by binary search and erased at once, and the list stays sorted.
     ///
     /// \param range The range to remove.
     void remove(const IndexRange& range);
 
+    /// \brief Remove all ranges of another list from this list.
+    /// \param other The list to remove.
+    void remove(const IndexRangeList_& other);
+
     /// \brief Expand and shift any matching matching range.
     ///
     /// If a range covers this insertion index, the range's size
@@ -67,6 +197,38 @@ public:
     /// \param size The size of the erased section.
     void erase(const IndexRange& range);
 
+    /// \brief Apply a batch of inserts and erases in a single pass.
+    ///
+    /// All edit locations refer to the indices before the batch, so the
+    /// order of the edits does not matter. Each index moves up by the size
+    /// of every insert located before it and down by the number of erased
+    /// indices before it. Indices inside an erased range move to the start
+    /// of that range.
+    ///
+    /// For edits that do not overlap, this gives the same result as calling
+    /// insert() and erase() for each edit in order of decreasing location,
+    /// but runs in O(n + m log m) rather than O(n * m).
+    ///
+    /// Ranges moved past IndexRange::MAX are passed to
+    /// OverflowPolicy::overflow() and then clamped or removed, like insert().
+    ///
+    /// \param edits The edits to apply.
+    void apply(const std::vector<IndexRangeEdit>& edits);
+
+    /// \brief Apply a compiled sequence of inserts and erases.
+    ///
+    /// While all indices stay below IndexRange::MAX, this gives the same
+    /// result as calling insert() and erase() for each edit of the mapper in
+    /// order.
+    ///
+    /// A range whose end the mapper moved past IndexRange::MAX (see
+    /// IndexRangeMapper::isLost()) is passed to OverflowPolicy::overflow()
+    /// and then clamped or removed, like insert(). An end moved exactly to
+    /// MAX does not overflow.
+    ///
+    /// \param mapper The compiled edits to apply.
+    void apply(const IndexRangeMapper& mapper);
+
     /// \brief Clear all ranges.
     void clear();
 
@@ -79,26 +241,272 @@ public:
     /// \returns the sorted, merged ranges.
     std::vector<IndexRange> ranges() const;
 
+    /// \brief Iterate the sorted, merged ranges without copying them.
+    ///
+    /// The iterators are invalidated by any change to the list.
+    typedef IndexRangeVector::const_iterator const_iterator;
+
+    /// \returns an iterator to the first sorted range.
+    const_iterator begin() const;
+
+    /// \returns an iterator past the last sorted range.
+    const_iterator end() const;
+
+    /// \returns the first sorted range. The list must not be empty.
+    const IndexRange& front() const;
+
+    /// \returns the last sorted range. The list must not be empty.
+    const IndexRange& back() const;
+
+    /// \brief Determine if a range in the list contains the index.
+    /// \param index The index to test.
+    /// \returns true if the index is covered.
+    bool contains(std::size_t index) const;
+
+    /// \brief Get the total number of indices covered by all ranges.
+    ///
+    /// The count is maintained as ranges are added and removed, so this
+    /// does not scan the ranges.
+    ///
+    /// \returns the number of covered indices.
+    std::size_t cardinality() const;
+
+    /// \brief Get the number of covered indices less than \p index.
+    ///
+    /// This maps an index in the sparse space to its position in the
+    /// compacted space of covered indices. Runs in O(log n).
+    ///
+    /// \param index The index to rank.
+    /// \returns the number of covered indices less than \p index.
+    std::size_t rank(std::size_t index) const;
+
+    /// \brief Get the k-th covered index.
+    ///
+    /// This is the inverse of rank() and maps a position in the compacted
+    /// space back to the sparse space. Runs in O(log n).
+    ///
+    /// \param k The zero-based position of the covered index.
+    /// \returns the k-th covered index or IndexRange::MAX if k >= cardinality().
+    std::size_t select(std::size_t k) const;
+
+    /// \brief Call a function for every covered index, in parallel.
+    ///
+    /// The covered indices are split into chunks of equal cardinality,
+    /// cutting ranges where needed, so a few huge ranges among many tiny ones
+    /// still balance across threads. Chunks are handed out to idle threads by
+    /// IndexRangeParallel::forEach(). The function receives contiguous
+    /// sub-ranges of at most one chunk, along with the rank of the first
+    /// index in the sub-range, and may be called concurrently. If the
+    /// function throws, the first exception is rethrown on the calling thread.
+    ///
+    /// Runs on the calling thread if IndexRangeParallel::numThreads() is 1 or
+    /// the cardinality is at most \p grainSize.
+    ///
+    /// \param function The function to call with each sub-range and its rank.
+    /// \param grainSize The minimum number of indices per chunk.
+    void forEachParallel(const std::function<void(const IndexRange&, std::size_t)>& function,
+                         std::size_t grainSize = 4096) const;
+
+    /// \brief Determine the union of this list and the other.
+    ///
+    /// Both lists are combined with a single linear pass. Large lists are
+    /// partitioned and combined in parallel (see IndexRangeParallel).
+    ///
+    /// \param other The other list.
+    /// \returns a list covering the indices covered by either list.
+    IndexRangeList_ unionWith(const IndexRangeList_& other) const;
+
+    /// \brief Determine the intersection of this list and the other.
+    /// \param other The other list.
+    /// \returns a list covering the indices covered by both lists.
+    IndexRangeList_ intersectionWith(const IndexRangeList_& other) const;
+
+    /// \brief Determine the difference of this list and the other.
+    /// \param other The other list.
+    /// \returns a list covering the indices covered by this list but not the other.
+    IndexRangeList_ differenceWith(const IndexRangeList_& other) const;
+
+    /// \brief Determine if this list covers the same indices as the other.
+    ///
+    /// Lists with different fingerprints (see hash()) are rejected without
+    /// comparing their ranges.
+    ///
+    /// \param other The other list.
+    /// \returns true if both lists have the same sorted, merged ranges.
+    bool operator == (const IndexRangeList_& other) const;
+    bool operator != (const IndexRangeList_& other) const;
+
+    /// \brief Get a fingerprint of the covered indices.
+    ///
+    /// The fingerprint is an order-independent sum of a hash of each merged
+    /// range, so add(), remove() and insert() on a sorted list update it in
+    /// O(1). Other edits mark it stale, and it is recomputed on the next call.
+    /// Lists covering the same indices have the same fingerprint.
+    ///
+    /// \returns the fingerprint.
+    uint64_t hash() const;
+
+    /// \brief Merge nearby ranges into larger requests.
+    ///
+    /// Unlike IndexRange::mergeWith(), ranges separated by a gap of up to
+    /// IndexRangeCoalesceSettings::maxGap are merged. This is useful when
+    /// planning I/O, where reading a small hole is cheaper than issuing a
+    /// separate request.
+    ///
+    /// The list itself is not modified.
+    ///
+    /// \param settings The coalescing settings.
+    /// \returns the sorted requests, each with the original ranges it covers.
+    std::vector<IndexRangeRequest> coalesce(const IndexRangeCoalesceSettings& settings) const;
+
+    /// \brief Write the covered indices to a dense bitset.
+    ///
+    /// Index i is stored in bit (i % 64) of words[i / 64]. Whole words are
+    /// filled with memset(), so the cost depends on the number of ranges and
+    /// words rather than the number of bits.
+    ///
+    /// \param words The output, with room for (numBits + 63) / 64 words.
+    /// \param numBits The number of bits to write. Indices past this are
+    ///        ignored and the unused bits of the last word are cleared.
+    void toBitset(uint64_t* words, std::size_t numBits) const;
+
+    /// \brief Write the covered indices to a dense bitset.
+    /// \param numBits The number of bits to write.
+    /// \returns the (numBits + 63) / 64 words of the bitset.
+    std::vector<uint64_t> toBitset(std::size_t numBits) const;
+
+    /// \brief Create a list from a dense bitset.
+    ///
+    /// Runs are found a word at a time by locating the bits where the
+    /// bitset changes between 0 and 1, so uniform words are skipped.
+    ///
+    /// \param words The bitset, in the layout used by toBitset().
+    /// \param numBits The number of bits to read.
+    /// \returns a list covering the set bits.
+    static IndexRangeList_ fromBitset(const uint64_t* words, std::size_t numBits);
+
+    /// \brief Create a list from a dense bitset.
+    /// \param words The bitset, in the layout used by toBitset().
+    /// \returns a list covering the set bits.
+    static IndexRangeList_ fromBitset(const std::vector<uint64_t>& words);
+
+    /// \brief Determine if a bitset would be smaller than the ranges.
+    /// \param numBits The size of the bitset.
+    /// \returns true if a bitset of numBits bits uses less memory than the
+    ///          sorted ranges of this list.
+    bool isSmallerAsBitset(std::size_t numBits) const;
+
     /// \brief Get valid range.
     ///
     /// All functions in the IndexRangeList use validated ranges.
     ///
-    /// A validated range is a range with no overflow.
+    /// A validated range is a range with no overflow. Ranges that overflow
+    /// are passed to OverflowPolicy::overflow() and then clamped.
     ///
     /// \returns a well-formed range.
     static IndexRange validate(const IndexRange& range);
 
 private:
+    /// \brief The binary set operations.
+    enum class Operation
+    {
+        UNION,
+        INTERSECTION,
+        DIFFERENCE
+    };
+
+    /// \brief Combine two lists with a set operation.
+    /// \param a The first list.
+    /// \param b The second list.
+    /// \param operation The operation to apply.
+    /// \returns the combined list.
+    static IndexRangeList_ _combine(const IndexRangeList_& a,
+                                    const IndexRangeList_& b,
+                                    Operation operation);
+
     /// \brief Will sort _ranges.
+    ///
+    /// Only the ranges after _sortedSize are sorted, then merged with the
+    /// sorted prefix. Large batches are sorted in parallel.
     void _sort() const;
 
-    /// \brief True if _ranges has been sorted via _sort().
-    mutable bool _sorted = false;
+    /// \brief Will update _offsets if needed.
+    void _updateOffsets() const;
+
+    /// \brief Get the fingerprint of the ranges in [first, last].
+    ///
+    /// The range at last is included because its gap depends on the range
+    /// before it. Ranges past the end are ignored.
+    uint64_t _hashOf(std::size_t first, std::size_t last) const;
+
+    /// \brief Replace the ranges with sorted, merged ranges.
+    /// \param ranges The new ranges.
+    void _assignSorted(IndexRangeVector&& ranges);
 
     /// \brief The ranges.
-    mutable std::vector<IndexRange> _ranges;
+    ///
+    /// Small lists are stored inline and do not allocate.
+    mutable IndexRangeVector _ranges;
+
+    /// \brief The number of leading ranges in _ranges known to be sorted.
+    ///
+    /// The sorted prefix is not necessarily merged.
+    mutable std::size_t _sortedSize = 0;
+
+    /// \brief The number of covered indices, valid when _sorted is true.
+    mutable std::size_t _cardinality = 0;
+
+    /// \brief The fingerprint returned by hash().
+    mutable uint64_t _hash = 0;
+
+    /// \brief The number of covered indices before each range in _ranges.
+    ///
+    /// Only lists with more than IndexRangeVector::INLINE_CAPACITY ranges
+    /// use it for rank() and select(), so it is allocated on first use.
+    mutable std::unique_ptr<std::vector<std::size_t>> _offsets;
+
+    /// \brief True if _ranges has been sorted via _sort().
+    mutable bool _sorted: 1;
+
+    /// \brief True if _offsets matches _ranges.
+    mutable bool _offsetsValid: 1;
+
+    /// \brief True if _hash matches the merged ranges.
+    mutable bool _hashValid: 1;
 
 };
 
 
+extern template class IndexRangeList_<IndexRangeClampPolicy>;
+extern template class IndexRangeList_<IndexRangeCheckedPolicy>;
+extern template class IndexRangeList_<IndexRangeUncheckedPolicy>;
+
+
+/// \brief A list that clamps ranges to IndexRange::MAX.
+typedef IndexRangeList_<IndexRangeClampPolicy> IndexRangeList;
+
+/// \brief A list that throws std::overflow_error for ranges that overflow.
+typedef IndexRangeList_<IndexRangeCheckedPolicy> CheckedIndexRangeList;
+
+/// \brief A list that trusts all ranges to be well formed.
+typedef IndexRangeList_<IndexRangeUncheckedPolicy> UncheckedIndexRangeList;
+
+
 } // namespace ofx
+
+
+namespace std {
+
+
+/// \brief Hash lists by their fingerprint, so they can be used as keys.
+template <typename OverflowPolicy>
+struct hash<ofx::IndexRangeList_<OverflowPolicy>>
+{
+    std::size_t operator()(const ofx::IndexRangeList_<OverflowPolicy>& list) const
+    {
+        return static_cast<std::size_t>(list.hash());
+    }
+};
+
+
+} // namespace std
@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include <unordered_set>
+#include <vector>
+#include "ofx/IndexRangeIntervalTree.h"
+#include "ofx/IndexRangeList.h"
+
+
+namespace ofx {
+
+
+/// \brief An inverted index over many IndexRangeLists, keyed by ID.
+///
+/// Answers "which lists cover index i" without visiting every list. The
+/// ranges of all lists share a single IndexRangeIntervalTree, so queries cost
+/// O(log N + k) for N stored ranges and k answers.
+///
+/// Updates to a single list are incremental: its old ranges are marked with
+/// a tombstone and its new ranges go to a small delta tree. The two trees are
+/// merged again once the delta and tombstones grow past a fraction of the
+/// main tree, or when compact() is called.
+class IndexRangeListIndex
+{
+public:
+    /// \brief Create an empty index.
+    IndexRangeListIndex();
+
+    /// \brief Add or replace a list.
+    ///
+    /// An empty list removes the ID.
+    ///
+    /// \param id The list ID.
+    /// \param list The list ranges.
+    void set(std::size_t id, const IndexRangeList& list);
+
+    /// \brief Remove a list.
+    /// \param id The list ID.
+    /// \returns true if the list was present.
+    bool remove(std::size_t id);
+
+    /// \brief Remove all lists.
+    void clear();
+
+    /// \returns true if there are no lists.
+    bool empty() const;
+
+    /// \returns the number of non-empty lists.
+    std::size_t size() const;
+
+    /// \brief Determine if a list is present.
+    /// \param id The list ID.
+    /// \returns true if the list is present and not empty.
+    bool contains(std::size_t id) const;
+
+    /// \brief Find the lists that contain an index.
+    /// \param index The index to query.
+    /// \returns the sorted IDs of the lists.
+    std::vector<std::size_t> stab(std::size_t index) const;
+
+    /// \brief Find the lists that contain any index in a range.
+    /// \param range The range to query.
+    /// \returns the sorted IDs of the lists.
+    std::vector<std::size_t> overlapping(const IndexRange& range) const;
+
+    /// \brief Find the lists that contain every index in a range.
+    /// \param range The range to query. It must not be empty.
+    /// \returns the sorted IDs of the lists.
+    std::vector<std::size_t> covering(const IndexRange& range) const;
+
+    /// \brief Merge the delta into the main tree and drop tombstones.
+    void compact();
+
+private:
+    /// \brief Call a function for each live interval that overlaps a range.
+    void _forEachOverlapping(const IndexRange& range,
+                             const std::function<void(const IndexRangeInterval&)>& function) const;
+
+    /// \brief Compact if the delta or tombstones have grown too large.
+    void _compactIfNeeded();
+
+    /// \brief The ranges of all lists at the last compaction.
+    IndexRangeIntervalTree _main;
+
+    /// \brief The IDs of the lists in _main.
+    std::unordered_set<std::size_t> _mainIds;
+
+    /// \brief The IDs of the lists in _main that were replaced or removed.
+    std::unordered_set<std::size_t> _tombstones;
+
+    /// \brief The ranges of the lists set since the last compaction.
+    IndexRangeIntervalTree _delta;
+
+    /// \brief The IDs of the lists in _delta.
+    std::unordered_set<std::size_t> _deltaIds;
+
+};
+
+
+} // namespace ofx
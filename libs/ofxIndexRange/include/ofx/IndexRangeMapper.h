@@ -0,0 +1,247 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+#include "ofx/IndexRangeEdit.h"
+
+
+namespace ofx {
+
+
+/// \brief Maps indices through a sequence of inserts and erases.
+///
+/// The edits are compiled into a sorted table of pieces. Each piece covers a
+/// run of original indices that is either shifted by a constant offset or
+/// collapsed onto a single index by an erase. Mapping an index is a binary
+/// search over the pieces, and mapping a sorted batch is a single linear
+/// walk.
+///
+/// Indices are treated as positions between elements, the same way
+/// IndexRangeList treats range boundaries:
+///
+/// - insert(range) moves every index greater than range.location up by
+///   range.size. An index equal to range.location does not move.
+/// - erase(range) moves every index greater than or equal to range.getMax()
+///   down by range.size. An index strictly inside the erased range is
+///   collapsed onto range.location. The indices at both ends survive.
+///
+/// Indices that an insert would move past IndexRange::MAX are mapped to MAX,
+/// and are not moved by later edits.
+///
+/// While edits are appended, the pieces are kept in a balanced tree ordered
+/// by mapped value, with pending shifts stored on subtrees. Each insert() or
+/// erase() runs in O(log n) expected time for n pieces, so compiling e edits
+/// takes O(e log e). The first query after a batch of edits flattens the tree
+/// into the sorted table in O(n).
+class IndexRangeMapper
+{
+public:
+    /// \brief How indices strictly inside an erased range are mapped.
+    enum class Policy
+    {
+        /// \brief Map the index to the start of the erased range.
+        CLAMP,
+        /// \brief Map the index to IndexRange::MAX.
+        INVALID
+    };
+
+    /// \brief Create an identity mapper.
+    IndexRangeMapper();
+
+    /// \brief Create a mapper from a sequence of edits.
+    ///
+    /// Unlike IndexRangeList::apply(), each edit refers to the indices after
+    /// all previous edits, as if insert() and erase() were called in order.
+    ///
+    /// \param edits The edits to compile.
+    IndexRangeMapper(const std::vector<IndexRangeEdit>& edits);
+
+    /// \brief Append an insert to the edit sequence.
+    /// \param range The inserted range.
+    void insert(const IndexRange& range);
+
+    /// \brief Append an erase to the edit sequence.
+    /// \param range The erased range.
+    void erase(const IndexRange& range);
+
+    /// \brief Append an edit to the edit sequence.
+    /// \param edit The edit to append.
+    void apply(const IndexRangeEdit& edit);
+
+    /// \brief Reset to the identity mapping.
+    void clear();
+
+    /// \returns true if every index maps to itself.
+    bool isIdentity() const;
+
+    /// \returns the number of pieces in the compiled table.
+    std::size_t size() const;
+
+    /// \brief Determine if an index was strictly inside an erased range.
+    /// \param index The original index.
+    /// \returns true if the index was erased.
+    bool isErased(std::size_t index) const;
+
+    /// \brief Determine if an edit moved an index past IndexRange::MAX.
+    ///
+    /// Lost indices are mapped to MAX, like an index moved exactly to MAX.
+    /// They always form the last pieces of the table, so this runs in O(1).
+    ///
+    /// \param index The original index.
+    /// \returns true if the index was lost.
+    bool isLost(std::size_t index) const;
+
+    /// \brief Map a single index.
+    /// \param index The original index.
+    /// \param policy How to map erased indices.
+    /// \returns the index after all edits.
+    std::size_t map(std::size_t index, Policy policy = Policy::CLAMP) const;
+
+    /// \brief Map a batch of indices.
+    ///
+    /// Sorted input is mapped with a linear walk in O(count + size()).
+    /// Otherwise each index costs O(log(size())). The input and output may
+    /// be the same buffer.
+    ///
+    /// \param input The original indices.
+    /// \param output The mapped indices.
+    /// \param count The number of indices.
+    /// \param policy How to map erased indices.
+    void map(const std::size_t* input,
+             std::size_t* output,
+             std::size_t count,
+             Policy policy = Policy::CLAMP) const;
+
+    /// \brief Map a batch of indices.
+    /// \param indices The original indices.
+    /// \param policy How to map erased indices.
+    /// \returns the mapped indices.
+    std::vector<std::size_t> map(const std::vector<std::size_t>& indices,
+                                 Policy policy = Policy::CLAMP) const;
+
+private:
+    /// \brief A run of original indices with the same mapping.
+    struct Piece
+    {
+        /// \brief The first original index of the piece.
+        std::size_t source = 0;
+
+        /// \brief The mapped value of the first index.
+        std::size_t target = 0;
+
+        /// \brief True if all indices of the piece collapse onto target.
+        bool erased = false;
+
+        /// \brief True if the indices of the piece were moved past
+        ///        IndexRange::MAX. They map to MAX and no longer move.
+        bool lost = false;
+
+    };
+
+    /// \brief Map an index through a piece.
+    static std::size_t _map(const Piece& piece,
+                            std::size_t index,
+                            Policy policy);
+
+    /// \brief The index of a missing node.
+    static const std::size_t NONE = std::size_t(-1);
+
+    /// \brief A piece in the edit tree.
+    struct Node
+    {
+        /// \brief The piece, with the pending shifts of its ancestors applied.
+        Piece piece;
+
+        /// \brief The left child, or NONE.
+        std::size_t left = NONE;
+
+        /// \brief The right child, or NONE.
+        std::size_t right = NONE;
+
+        /// \brief The heap priority of the node.
+        uint64_t priority = 0;
+
+        /// \brief The pending shift of the children's targets.
+        ///
+        /// Shifts are composed modulo 2^64. Pieces that would move past
+        /// IndexRange::MAX are lost instead of shifted, so every shifted
+        /// target stays in [0, MAX] and the wrapped sum is exact.
+        std::size_t shift = 0;
+
+        /// \brief True if the children are pending a move past MAX.
+        bool lose = false;
+
+    };
+
+    /// \brief Rebuild the edit tree from _pieces if needed.
+    void _edit();
+
+    /// \brief Flatten the edit tree into _pieces if needed.
+    void _compile() const;
+
+    /// \brief Append the pieces of a subtree to _pieces, in order.
+    void _collect(std::size_t node) const;
+
+    /// \returns the index of a new node.
+    std::size_t _newNode(const Piece& piece);
+
+    /// \brief Shift the targets of a subtree, or mark its pieces as lost.
+    void _apply(std::size_t node, bool lose, std::size_t shift) const;
+
+    /// \brief Pass the pending shift of a node to its children.
+    void _push(std::size_t node) const;
+
+    /// \brief Split a subtree into the nodes with targets below value and
+    ///        the rest.
+    void _splitTree(std::size_t node,
+                    std::size_t value,
+                    std::size_t& left,
+                    std::size_t& right);
+
+    /// \returns the root of the merged subtrees, all of left before right.
+    std::size_t _merge(std::size_t left, std::size_t right);
+
+    /// \returns the first node of a subtree.
+    std::size_t _first(std::size_t node);
+
+    /// \returns the last node of a subtree.
+    std::size_t _last(std::size_t node);
+
+    /// \brief Split the pieces so that a piece starts at a mapped value.
+    void _split(std::size_t value);
+
+    /// \brief Merge neighboring pieces with the same mapping.
+    void _compact() const;
+
+    /// \brief The pieces, sorted by source. The first source is always 0.
+    ///
+    /// Valid when _compiled is true.
+    mutable std::vector<Piece> _pieces;
+
+    /// \brief The first lost piece, or _pieces.size() if there is none.
+    ///
+    /// Valid when _compiled is true.
+    mutable std::size_t _firstLost = 1;
+
+    /// \brief True if _pieces matches the edits.
+    mutable bool _compiled = true;
+
+    /// \brief The nodes of the edit tree. Nodes cut from the tree are not
+    ///        reused until it is rebuilt.
+    mutable std::vector<Node> _nodes;
+
+    /// \brief The root of the edit tree, or NONE if it must be rebuilt.
+    mutable std::size_t _root = NONE;
+
+};
+
+
+} // namespace ofx
@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include <cstddef>
+#include <functional>
+
+
+namespace ofx {
+
+
+/// \brief Shared configuration and helpers for parallel range algorithms.
+///
+/// Lists with at least threshold() ranges are sorted and combined using up
+/// to numThreads() threads. Smaller lists always use the sequential paths.
+class IndexRangeParallel
+{
+public:
+    /// \brief Set the number of threads used by parallel algorithms.
+    ///
+    /// A value of 0 uses std::thread::hardware_concurrency(). A value of 1
+    /// disables the parallel paths.
+    ///
+    /// \param numThreads The number of threads.
+    static void setNumThreads(std::size_t numThreads);
+
+    /// \returns the number of threads used by parallel algorithms.
+    static std::size_t numThreads();
+
+    /// \brief Set the minimum number of ranges required for a parallel path.
+    /// \param threshold The minimum number of ranges.
+    static void setThreshold(std::size_t threshold);
+
+    /// \returns the minimum number of ranges required for a parallel path.
+    static std::size_t threshold();
+
+    /// \brief Determine if an operation over \p count ranges runs in parallel.
+    /// \param count The number of ranges.
+    /// \returns true if count >= threshold() and numThreads() > 1.
+    static bool isParallel(std::size_t count);
+
+    /// \brief Run task(i) for each i in [0, count).
+    ///
+    /// Tasks are handed out to up to numThreads() threads, including the
+    /// calling thread. The other threads belong to a pool that is started on
+    /// first use and reused by later calls, so a call does not create
+    /// threads. Returns when all tasks have finished.
+    ///
+    /// If a task throws, the remaining tasks are skipped and the first
+    /// exception is rethrown on the calling thread.
+    ///
+    /// \param count The number of tasks.
+    /// \param task The task to run.
+    static void forEach(std::size_t count,
+                        const std::function<void(std::size_t)>& task);
+
+};
+
+
+} // namespace ofx
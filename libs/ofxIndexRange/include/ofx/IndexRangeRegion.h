@@ -0,0 +1,197 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include "ofx/IndexRangeList.h"
+
+
+namespace ofx {
+
+
+/// \brief An axis-aligned rectangle made of an x and a y IndexRange.
+class IndexRangeRect
+{
+public:
+    /// \brief Create an empty rectangle.
+    IndexRangeRect();
+
+    /// \brief Create a rectangle from its x and y ranges.
+    /// \param x The horizontal range.
+    /// \param y The vertical range.
+    IndexRangeRect(const IndexRange& x, const IndexRange& y);
+
+    /// \brief Create a rectangle from a position and size.
+    /// \param x The left edge.
+    /// \param y The top edge.
+    /// \param width The width.
+    /// \param height The height.
+    IndexRangeRect(std::size_t x, std::size_t y, std::size_t width, std::size_t height);
+
+    /// \returns true if the width or height is 0.
+    bool empty() const;
+
+    /// \returns the number of covered cells, width * height.
+    std::size_t area() const;
+
+    /// \brief Determine if this rectangle contains the cell.
+    /// \param x The x location to test.
+    /// \param y The y location to test.
+    /// \returns true if the cell is within the rectangle.
+    bool contains(std::size_t x, std::size_t y) const;
+
+    /// \brief Determine the bounding rectangle of this and the other.
+    /// \param other The other rectangle.
+    /// \returns the smallest rectangle containing both rectangles.
+    IndexRangeRect unionWith(const IndexRangeRect& other) const;
+
+    bool operator == (const IndexRangeRect& other) const;
+    bool operator != (const IndexRangeRect& other) const;
+
+    /// \brief The horizontal range.
+    IndexRange x;
+
+    /// \brief The vertical range.
+    IndexRange y;
+
+    friend std::ostream& operator << (std::ostream& os, const IndexRangeRect& rect);
+
+};
+
+
+inline std::ostream& operator << (std::ostream& os, const IndexRangeRect& rect)
+{
+    os << "{" << rect.x << "," << rect.y << "}";
+    return os;
+}
+
+
+/// \brief A 2D region made of non-overlapping rectangles.
+///
+/// The region is stored as horizontal bands sorted by y. Each band holds an
+/// IndexRangeList of the x ranges covered on every row of the band. Bands
+/// never overlap and vertically adjacent bands with identical x ranges are
+/// merged, so the representation of a region is unique (similar to pixman
+/// and X11 regions).
+class IndexRangeRegion
+{
+public:
+    /// \brief Create an empty region.
+    IndexRangeRegion();
+
+    /// \brief Create a region from a rectangle.
+    /// \param rect The rectangle.
+    IndexRangeRegion(const IndexRangeRect& rect);
+
+    /// \brief Add a rectangle to the region.
+    /// \param rect The rectangle to add.
+    void add(const IndexRangeRect& rect);
+
+    /// \brief Add another region to the region.
+    /// \param other The region to add.
+    void add(const IndexRangeRegion& other);
+
+    /// \brief Remove a rectangle from the region.
+    /// \param rect The rectangle to remove.
+    void remove(const IndexRangeRect& rect);
+
+    /// \brief Remove another region from the region.
+    /// \param other The region to remove.
+    void remove(const IndexRangeRegion& other);
+
+    /// \brief Keep only the part of the region inside the rectangle.
+    /// \param rect The rectangle to intersect with.
+    void intersect(const IndexRangeRect& rect);
+
+    /// \brief Keep only the part of the region inside the other region.
+    /// \param other The region to intersect with.
+    void intersect(const IndexRangeRegion& other);
+
+    /// \param other The other region.
+    /// \returns the union of this region and the other.
+    IndexRangeRegion unionWith(const IndexRangeRegion& other) const;
+
+    /// \param other The other region.
+    /// \returns the intersection of this region and the other.
+    IndexRangeRegion intersectionWith(const IndexRangeRegion& other) const;
+
+    /// \param other The other region.
+    /// \returns this region with the other region removed.
+    IndexRangeRegion differenceWith(const IndexRangeRegion& other) const;
+
+    /// \brief Remove everything from the region.
+    void clear();
+
+    /// \returns true if the region is empty.
+    bool empty() const;
+
+    /// \brief Determine if this region contains the cell.
+    /// \param x The x location to test.
+    /// \param y The y location to test.
+    /// \returns true if the cell is within the region.
+    bool contains(std::size_t x, std::size_t y) const;
+
+    /// \returns the number of covered cells.
+    std::size_t area() const;
+
+    /// \returns the smallest rectangle containing the region.
+    IndexRangeRect bounds() const;
+
+    /// \brief Get the rectangles making up the region.
+    ///
+    /// Each band contributes one rectangle per x range, sorted by y then x.
+    ///
+    /// \returns the non-overlapping rectangles covering exactly the region.
+    std::vector<IndexRangeRect> rects() const;
+
+    /// \brief Get at most \p maxCount rectangles covering the region.
+    ///
+    /// If the region needs more than \p maxCount rectangles, neighboring
+    /// rectangles are greedily replaced by their bounds, choosing the pair
+    /// that adds the fewest uncovered cells each time. The result covers the
+    /// region but may cover cells outside of it and may overlap.
+    ///
+    /// \param maxCount The maximum number of rectangles, at least 1.
+    /// \returns the rectangles covering the region.
+    std::vector<IndexRangeRect> rects(std::size_t maxCount) const;
+
+    bool operator == (const IndexRangeRegion& other) const;
+    bool operator != (const IndexRangeRegion& other) const;
+
+private:
+    /// \brief A horizontal band of the region.
+    struct Band
+    {
+        /// \brief The rows covered by the band.
+        IndexRange y;
+
+        /// \brief The columns covered on each row of the band.
+        IndexRangeList x;
+
+    };
+
+    /// \brief The binary region operations.
+    enum class Operation
+    {
+        UNION,
+        INTERSECTION,
+        DIFFERENCE
+    };
+
+    /// \brief Combine two regions band by band.
+    static IndexRangeRegion _combine(const IndexRangeRegion& a,
+                                     const IndexRangeRegion& b,
+                                     Operation operation);
+
+    /// \brief The sorted, non-overlapping bands.
+    std::vector<Band> _bands;
+
+};
+
+
+} // namespace ofx
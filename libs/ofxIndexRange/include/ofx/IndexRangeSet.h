@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+#include "ofx/IndexRangeList.h"
+
+
+namespace ofx {
+
+
+/// \brief A chunk of IndexRangeSet::CHUNK_SIZE indices.
+///
+/// Only the storage for the current type is used. Values are relative to the
+/// start of the chunk.
+struct IndexRangeSetChunk
+{
+    /// \brief The storage used by a chunk.
+    enum class Type
+    {
+        /// \brief A sorted array of 16-bit values.
+        ARRAY,
+        /// \brief A bitmap with one bit per index.
+        BITMAP,
+        /// \brief A sorted, merged list of runs.
+        RUN
+    };
+
+    /// \brief The chunk number, i.e. the first index >> CHUNK_BITS.
+    std::size_t key = 0;
+
+    /// \brief The storage type.
+    Type type = Type::ARRAY;
+
+    /// \brief The number of indices in the chunk.
+    std::size_t cardinality = 0;
+
+    /// \brief The values for Type::ARRAY.
+    std::vector<uint16_t> array;
+
+    /// \brief The words for Type::BITMAP.
+    std::vector<uint64_t> bitmap;
+
+    /// \brief The runs for Type::RUN.
+    std::vector<IndexRange> runs;
+
+};
+
+
+/// \brief A compressed set of indices for mixed dense and sparse coverage.
+///
+/// The index space is split into chunks of CHUNK_SIZE indices, in the style
+/// of Roaring bitmaps. Each chunk is stored as a sorted array, a bitmap or a
+/// list of runs, whichever is smallest. Highly fragmented regions use 2
+/// bytes per index or 1 bit per index rather than 16 bytes per IndexRange,
+/// while long runs still use a single IndexRange.
+///
+/// Range operations and set operations pick the smallest storage for each
+/// resulting chunk. Adding or removing single indices only converts a chunk
+/// when it crosses a size threshold, so call optimize() after many point
+/// edits.
+class IndexRangeSet
+{
+public:
+    typedef IndexRangeSetChunk Chunk;
+
+    /// \brief The number of index bits addressed within a chunk.
+    static const std::size_t CHUNK_BITS = 16;
+
+    /// \brief The number of indices in a chunk.
+    static const std::size_t CHUNK_SIZE = std::size_t(1) << CHUNK_BITS;
+
+    /// \brief The largest number of indices stored as an array.
+    static const std::size_t MAX_ARRAY_SIZE = 4096;
+
+    /// \brief Create an empty set.
+    IndexRangeSet();
+
+    /// \brief Create a set covering the indices of a list.
+    /// \param list The list to copy.
+    IndexRangeSet(const IndexRangeList& list);
+
+    /// \brief Add a single index.
+    /// \param index The index to add.
+    void add(std::size_t index);
+
+    /// \brief Add the indices of a range.
+    ///
+    /// Only the chunks the range overlaps are updated. This runs in
+    /// O(log n + k) for n chunks, k of which overlap the range, plus the cost
+    /// of moving the later chunks if chunks are inserted or erased.
+    ///
+    /// \param range The range to add.
+    void add(const IndexRange& range);
+
+    /// \brief Remove a single index.
+    /// \param index The index to remove.
+    void remove(std::size_t index);
+
+    /// \brief Remove the indices of a range.
+    ///
+    /// Only the chunks the range overlaps are updated. This runs in
+    /// O(log n + k) for n chunks, k of which overlap the range, plus the cost
+    /// of moving the later chunks if chunks are inserted or erased.
+    ///
+    /// \param range The range to remove.
+    void remove(const IndexRange& range);
+
+    /// \brief Remove all indices.
+    void clear();
+
+    /// \returns true if there are no indices.
+    bool empty() const;
+
+    /// \returns the number of indices in the set.
+    std::size_t cardinality() const;
+
+    /// \param index The index to test.
+    /// \returns true if the index is in the set.
+    bool contains(std::size_t index) const;
+
+    /// \brief Convert every chunk to its smallest storage type.
+    void optimize();
+
+    /// \returns the number of bytes used by the chunk storage.
+    std::size_t sizeInBytes() const;
+
+    /// \returns the chunks, sorted by key.
+    const std::vector<Chunk>& chunks() const;
+
+    /// \brief Determine the union of this set and the other.
+    /// \param other The other set.
+    /// \returns a set containing the indices in either set.
+    IndexRangeSet unionWith(const IndexRangeSet& other) const;
+
+    /// \brief Determine the intersection of this set and the other.
+    /// \param other The other set.
+    /// \returns a set containing the indices in both sets.
+    IndexRangeSet intersectionWith(const IndexRangeSet& other) const;
+
+    /// \brief Determine the difference of this set and the other.
+    /// \param other The other set.
+    /// \returns a set containing the indices in this set but not the other.
+    IndexRangeSet differenceWith(const IndexRangeSet& other) const;
+
+    /// \brief Determine if this set contains the same indices as the other.
+    ///
+    /// Chunks with different storage types are compared by content.
+    ///
+    /// \param other The other set.
+    /// \returns true if both sets contain the same indices.
+    bool operator == (const IndexRangeSet& other) const;
+    bool operator != (const IndexRangeSet& other) const;
+
+    /// \returns an IndexRangeList covering the same indices.
+    IndexRangeList toList() const;
+
+private:
+    /// \returns the chunk with the given key, or nullptr.
+    Chunk* _find(std::size_t key);
+    const Chunk* _find(std::size_t key) const;
+
+    /// \brief The chunks, sorted by key. Empty chunks are removed.
+    std::vector<Chunk> _chunks;
+
+};
+
+
+} // namespace ofx
@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include "ofx/IndexRange.h"
+
+
+namespace ofx {
+
+
+/// \brief A sorted, merged list of ranges above a moving low watermark.
+///
+/// This is intended for streaming use, such as reassembling received data,
+/// where only the ranges above a moving watermark (e.g. acknowledged data)
+/// are of interest.
+///
+/// The ranges are stored in a ring buffer. Advancing the watermark drops the
+/// leading ranges in amortized O(1) without shifting the remaining ranges.
+/// Ranges added in order are appended in O(1). Out of order ranges are
+/// merged in place, shifting whichever side of the ring is shorter.
+class IndexRangeStream
+{
+public:
+    /// \brief Create an empty stream with a watermark of 0.
+    IndexRangeStream();
+
+    /// \brief Create an empty stream with the given watermark.
+    /// \param watermark The initial low watermark.
+    IndexRangeStream(std::size_t watermark);
+
+    /// \brief Add the given range.
+    ///
+    /// The range is validated and the part below the watermark is ignored.
+    /// Overlapping and adjacent ranges are merged.
+    ///
+    /// \param range The range to add.
+    void add(const IndexRange& range);
+
+    /// \brief Drop everything below the given watermark.
+    ///
+    /// The watermark never moves backwards, so smaller values are ignored.
+    ///
+    /// \param watermark The new low watermark.
+    void advanceWatermark(std::size_t watermark);
+
+    /// \returns the current low watermark.
+    std::size_t watermark() const;
+
+    /// \brief Get the end of the data that is contiguous from the watermark.
+    ///
+    /// This is the watermark if the index at the watermark is not covered.
+    ///
+    /// \returns the end of the contiguous prefix.
+    std::size_t contiguousPrefixEnd() const;
+
+    /// \brief Remove all ranges, keeping the watermark.
+    void clear();
+
+    /// \returns true if there are no ranges.
+    bool empty() const;
+
+    /// \returns the number of ranges.
+    std::size_t size() const;
+
+    /// \returns the number of indices covered by all ranges.
+    std::size_t cardinality() const;
+
+    /// \brief Get a range by its sorted position.
+    /// \param i The position of the range, less than size().
+    /// \returns the range.
+    const IndexRange& operator [] (std::size_t i) const;
+
+    /// \returns the sorted, merged ranges.
+    std::vector<IndexRange> ranges() const;
+
+private:
+    /// \returns the range at sorted position \p i.
+    IndexRange& _at(std::size_t i);
+
+    /// \brief Double the capacity of the ring, unwrapping it.
+    void _grow();
+
+    /// \brief Insert a range at sorted position \p i.
+    void _insert(std::size_t i, const IndexRange& range);
+
+    /// \brief Erase the ranges at sorted positions [first, last).
+    void _erase(std::size_t first, std::size_t last);
+
+    /// \brief The low watermark.
+    std::size_t _watermark = 0;
+
+    /// \brief The ring buffer. The size is zero or a power of two.
+    std::vector<IndexRange> _buffer;
+
+    /// \brief The position of the first range in _buffer.
+    std::size_t _head = 0;
+
+    /// \brief The number of ranges in _buffer.
+    std::size_t _size = 0;
+
+    /// \brief The number of indices covered by all ranges.
+    std::size_t _cardinality = 0;
+
+};
+
+
+} // namespace ofx
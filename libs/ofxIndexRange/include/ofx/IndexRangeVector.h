@@ -0,0 +1,148 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include <type_traits>
+#include "ofx/IndexRange.h"
+
+
+namespace ofx {
+
+
+/// \brief A contiguous IndexRange container with inline storage.
+///
+/// The first INLINE_CAPACITY ranges are stored inside the object itself. The
+/// container only allocates from the heap once it grows beyond that, so
+/// small lists (e.g. a selection or a single dirty region) never allocate.
+///
+/// The interface is a subset of std::vector<IndexRange>. Iterators are plain
+/// pointers and are invalidated by any operation that changes the capacity.
+class IndexRangeVector
+{
+public:
+    typedef IndexRange value_type;
+    typedef IndexRange* iterator;
+    typedef const IndexRange* const_iterator;
+
+    /// \brief The number of ranges stored without a heap allocation.
+    static const std::size_t INLINE_CAPACITY = 4;
+
+    /// \brief Create an empty IndexRangeVector using inline storage.
+    IndexRangeVector();
+
+    /// \brief Create an IndexRangeVector with a copy of the given ranges.
+    /// \param first The first range to copy.
+    /// \param last One past the last range to copy.
+    IndexRangeVector(const_iterator first, const_iterator last);
+
+    IndexRangeVector(const IndexRangeVector& other);
+    IndexRangeVector(IndexRangeVector&& other) noexcept;
+
+    /// \brief Destroy the IndexRangeVector.
+    ~IndexRangeVector();
+
+    IndexRangeVector& operator = (const IndexRangeVector& other);
+    IndexRangeVector& operator = (IndexRangeVector&& other) noexcept;
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    IndexRange* data();
+    const IndexRange* data() const;
+
+    IndexRange& operator [] (std::size_t i);
+    const IndexRange& operator [] (std::size_t i) const;
+
+    IndexRange& front();
+    const IndexRange& front() const;
+    IndexRange& back();
+    const IndexRange& back() const;
+
+    /// \returns true if there are no ranges.
+    bool empty() const;
+
+    /// \returns the number of ranges.
+    std::size_t size() const;
+
+    /// \returns the number of ranges that can be held without reallocating.
+    std::size_t capacity() const;
+
+    /// \returns true if the ranges are stored in the inline buffer.
+    bool isInline() const;
+
+    /// \brief Ensure capacity for at least \p count ranges.
+    /// \param count The number of ranges to reserve.
+    void reserve(std::size_t count);
+
+    /// \brief Resize the vector.
+    ///
+    /// New ranges are default constructed.
+    ///
+    /// \param count The new number of ranges.
+    void resize(std::size_t count);
+
+    /// \brief Remove all ranges, keeping the current capacity.
+    void clear();
+
+    /// \brief Append a range.
+    /// \param range The range to append.
+    void push_back(const IndexRange& range);
+
+    /// \brief Remove the last range.
+    void pop_back();
+
+    /// \brief Insert a range before \p position.
+    /// \param position The insert position.
+    /// \param range The range to insert.
+    /// \returns an iterator to the inserted range.
+    iterator insert(iterator position, const IndexRange& range);
+
+    /// \brief Erase the range at \p position.
+    /// \param position The range to erase.
+    /// \returns an iterator to the range following the erased range.
+    iterator erase(iterator position);
+
+    /// \brief Erase the ranges in [first, last).
+    /// \param first The first range to erase.
+    /// \param last One past the last range to erase.
+    /// \returns an iterator to the range following the erased ranges.
+    iterator erase(iterator first, iterator last);
+
+    /// \brief Exchange contents with another IndexRangeVector.
+    /// \param other The other vector.
+    void swap(IndexRangeVector& other) noexcept;
+
+private:
+    /// \brief Grow the capacity to at least \p count ranges.
+    void _grow(std::size_t count);
+
+    /// \brief Release any heap storage and return to the inline buffer.
+    void _release();
+
+    /// \brief Either the inline buffer or the heap allocation.
+    IndexRange* _data = nullptr;
+
+    /// \brief The number of ranges.
+    std::size_t _size = 0;
+
+    /// \brief The number of ranges _data can hold.
+    std::size_t _capacity = INLINE_CAPACITY;
+
+    /// \brief The inline storage.
+    alignas(IndexRange) unsigned char _buffer[INLINE_CAPACITY * sizeof(IndexRange)];
+
+    static_assert(std::is_trivially_copyable<IndexRange>::value,
+                  "IndexRangeVector relocates ranges with memcpy.");
+
+};
+
+
+} // namespace ofx
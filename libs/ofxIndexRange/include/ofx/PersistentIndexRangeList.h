@@ -0,0 +1,147 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#pragma once
+
+
+#include <memory>
+#include "ofx/IndexRangeList.h"
+
+
+namespace ofx {
+
+
+/// \brief A persistent IndexRangeList.
+///
+/// The ranges are stored in an immutable, path-copying balanced tree.
+/// Copying a list is O(1) and shares all of its ranges. Each edit creates
+/// O(log n) new nodes and leaves every other copy untouched, so keeping a
+/// copy of each version (e.g. for undo and redo) costs memory proportional
+/// to the edits made, not to the size of the list.
+///
+/// The semantics of add(), remove(), insert() and erase() match
+/// IndexRangeList.
+class PersistentIndexRangeList
+{
+public:
+    /// \brief Create a default empty PersistentIndexRangeList.
+    PersistentIndexRangeList();
+
+    /// \brief Create a PersistentIndexRangeList with the ranges of a list.
+    /// \param list The list to copy.
+    PersistentIndexRangeList(const IndexRangeList& list);
+
+    /// \brief Add the given range in O(log n).
+    /// \param range The range to add.
+    void add(const IndexRange& range);
+
+    /// \brief Remove the given range in O(log n).
+    /// \param range The range to remove.
+    void remove(const IndexRange& range);
+
+    /// \brief Expand and shift any matching range in O(log n).
+    /// \param range The range to insert.
+    void insert(const IndexRange& range);
+
+    /// \brief Truncate and shift any matching ranges in O(log n).
+    /// \param range The range to erase.
+    void erase(const IndexRange& range);
+
+    /// \brief Clear all ranges.
+    void clear();
+
+    /// \returns true if there are no ranges.
+    bool empty() const;
+
+    /// \returns the number of ranges.
+    std::size_t size() const;
+
+    /// \returns the number of indices covered by all ranges.
+    std::size_t cardinality() const;
+
+    /// \brief Determine if a range in the list contains the index.
+    /// \param index The index to test.
+    /// \returns true if the index is covered.
+    bool contains(std::size_t index) const;
+
+    /// \returns the sorted, merged ranges.
+    std::vector<IndexRange> ranges() const;
+
+    /// \returns an IndexRangeList with the same ranges.
+    IndexRangeList toList() const;
+
+    /// \brief Determine if both lists share the same version.
+    ///
+    /// This is an O(1) identity check. Lists that are not the same version
+    /// may still hold equal ranges.
+    ///
+    /// \param other The other list.
+    /// \returns true if both lists share the same tree.
+    bool isSameVersion(const PersistentIndexRangeList& other) const;
+
+private:
+    struct Node;
+    struct Tree;
+
+    /// \brief The root of the tree.
+    std::shared_ptr<const Node> _root;
+
+};
+
+
+/// \brief An undo and redo history of PersistentIndexRangeList versions.
+///
+/// Every version shares structure with its neighbors, so undo and redo only
+/// move a cursor.
+class IndexRangeListHistory
+{
+public:
+    /// \brief Create a history starting from an empty list.
+    IndexRangeListHistory();
+
+    /// \brief Create a history starting from the given version.
+    /// \param initial The initial version.
+    IndexRangeListHistory(const PersistentIndexRangeList& initial);
+
+    /// \returns the current version.
+    const PersistentIndexRangeList& current() const;
+
+    /// \brief Make \p version the current version.
+    ///
+    /// Any versions that could be redone are discarded.
+    ///
+    /// \param version The new version.
+    void commit(const PersistentIndexRangeList& version);
+
+    /// \returns true if there is a version to undo to.
+    bool canUndo() const;
+
+    /// \returns true if there is a version to redo to.
+    bool canRedo() const;
+
+    /// \brief Move to the previous version.
+    /// \returns true if successful.
+    bool undo();
+
+    /// \brief Move to the next version.
+    /// \returns true if successful.
+    bool redo();
+
+    /// \returns the number of versions in the history.
+    std::size_t size() const;
+
+private:
+    /// \brief All versions.
+    std::vector<PersistentIndexRangeList> _versions;
+
+    /// \brief The index of the current version.
+    std::size_t _current = 0;
+
+};
+
+
+} // namespace ofx
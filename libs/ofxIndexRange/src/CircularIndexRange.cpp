@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/CircularIndexRange.h"
+#include <algorithm>
+
+
+namespace ofx {
+
+
+CircularIndexRange::CircularIndexRange()
+{
+}
+
+
+CircularIndexRange::CircularIndexRange(std::size_t _location,
+                                       std::size_t _size,
+                                       std::size_t _capacity):
+    location(_capacity > 0 ? _location % _capacity : 0),
+    size(std::min(_size, _capacity)),
+    capacity(_capacity)
+{
+}
+
+
+bool CircularIndexRange::empty() const
+{
+    return 0 == size;
+}
+
+
+bool CircularIndexRange::wraps() const
+{
+    return size > capacity - location;
+}
+
+
+std::size_t CircularIndexRange::getMax() const
+{
+    return wraps() ? size - (capacity - location) : location + size;
+}
+
+
+bool CircularIndexRange::contains(std::size_t index) const
+{
+    if (empty())
+        return false;
+
+    index %= capacity;
+
+    std::size_t offset = index >= location ? index - location : capacity - location + index;
+    return offset < size;
+}
+
+
+std::size_t CircularIndexRange::numSpans() const
+{
+    if (empty())
+        return 0;
+
+    return wraps() ? 2 : 1;
+}
+
+
+IndexRange CircularIndexRange::first() const
+{
+    return IndexRange(location, std::min(size, capacity - location));
+}
+
+
+IndexRange CircularIndexRange::second() const
+{
+    return IndexRange(0, size - first().size);
+}
+
+
+bool CircularIndexRange::operator == (const CircularIndexRange& other) const
+{
+    return location == other.location
+        && size == other.size
+        && capacity == other.capacity;
+}
+
+
+bool CircularIndexRange::operator != (const CircularIndexRange& other) const
+{
+    return !(*this == other);
+}
+
+
+} // namespace ofx
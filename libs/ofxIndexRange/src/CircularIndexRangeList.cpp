@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/CircularIndexRangeList.h"
+#include <algorithm>
+
+
+namespace ofx {
+
+
+CircularIndexRangeList::CircularIndexRangeList()
+{
+}
+
+
+CircularIndexRangeList::CircularIndexRangeList(std::size_t capacity):
+    _capacity(std::min(capacity, IndexRange::MAX / 2))
+{
+}
+
+
+void CircularIndexRangeList::add(const CircularIndexRange& range)
+{
+    IndexRange unwrapped = _unwrap(range);
+
+    if (unwrapped.empty())
+        return;
+
+    _list.add(unwrapped);
+    _normalize();
+}
+
+
+void CircularIndexRangeList::remove(const CircularIndexRange& range)
+{
+    IndexRange unwrapped = _unwrap(range);
+
+    if (unwrapped.empty() || _list.empty())
+        return;
+
+    if (unwrapped.size == _capacity)
+    {
+        _list.clear();
+        return;
+    }
+
+    // Each index i may be stored as i or i + capacity.
+    _list.remove(unwrapped);
+    _list.remove(IndexRange::fromExclusiveInterval(unwrapped.location + _capacity,
+                                                   std::min(unwrapped.getMax() + _capacity, 2 * _capacity)));
+
+    if (unwrapped.getMax() > _capacity)
+        _list.remove(IndexRange(0, unwrapped.getMax() - _capacity));
+
+    _normalize();
+}
+
+
+void CircularIndexRangeList::clear()
+{
+    _list.clear();
+}
+
+
+bool CircularIndexRangeList::empty() const
+{
+    return _list.empty();
+}
+
+
+std::size_t CircularIndexRangeList::size() const
+{
+    return _list.size();
+}
+
+
+std::size_t CircularIndexRangeList::capacity() const
+{
+    return _capacity;
+}
+
+
+std::size_t CircularIndexRangeList::cardinality() const
+{
+    return _list.cardinality();
+}
+
+
+bool CircularIndexRangeList::contains(std::size_t index) const
+{
+    if (_capacity == 0)
+        return false;
+
+    index %= _capacity;
+    return _list.contains(index) || _list.contains(index + _capacity);
+}
+
+
+std::vector<CircularIndexRange> CircularIndexRangeList::ranges() const
+{
+    std::vector<CircularIndexRange> results;
+
+    for (auto& range: _list.ranges())
+        results.push_back(CircularIndexRange(range.location, range.size, _capacity));
+
+    return results;
+}
+
+
+IndexRange CircularIndexRangeList::_unwrap(const CircularIndexRange& range) const
+{
+    if (_capacity == 0)
+        return IndexRange();
+
+    CircularIndexRange wrapped(range.location, range.size, _capacity);
+    return IndexRange(wrapped.location, wrapped.size);
+}
+
+
+void CircularIndexRangeList::_normalize()
+{
+    // Ranges that lie entirely past the end move to the start of the ring.
+    while (!_list.empty() && _list.back().location >= _capacity)
+    {
+        IndexRange range = _list.back();
+        _list.remove(range);
+        _list.add(IndexRange(range.location - _capacity, range.size));
+    }
+
+    // The wrapped part of the last range absorbs the ranges it touches.
+    while (_list.size() > 1 && _list.back().getMax() >= _capacity)
+    {
+        IndexRange first = _list.front();
+
+        if (first.location > _list.back().getMax() - _capacity)
+            break;
+
+        _list.remove(first);
+        _list.add(IndexRange(first.location + _capacity, first.size));
+    }
+
+    if (!_list.empty() && _list.back().size >= _capacity)
+    {
+        _list.clear();
+        _list.add(IndexRange(0, _capacity));
+    }
+}
+
+
+} // namespace ofx
@@ -0,0 +1,501 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/CompressedIndexRangeList.h"
+#include <algorithm>
+#include "ofLog.h"
+
+
+namespace ofx {
+
+
+const std::size_t CompressedIndexRangeList::BLOCK_SIZE;
+
+
+namespace {
+
+
+const std::size_t WORD_BITS = 64;
+
+
+/// \returns the number of bits needed to store value.
+uint8_t bitsFor(uint64_t value)
+{
+    uint8_t bits = 0;
+
+    while (bits < WORD_BITS && (value >> bits) != 0)
+        ++bits;
+
+    return bits;
+}
+
+
+/// \brief Pack count values of the given width, starting at bit 0 of words.
+void packBits(const uint64_t* values, std::size_t count, uint8_t bits, uint64_t* words)
+{
+    if (bits == 0)
+        return;
+
+    std::size_t position = 0;
+
+    for (std::size_t i = 0; i < count; ++i, position += bits)
+    {
+        std::size_t word = position / WORD_BITS;
+        std::size_t shift = position % WORD_BITS;
+
+        words[word] |= values[i] << shift;
+
+        if (shift + bits > WORD_BITS)
+            words[word + 1] |= values[i] >> (WORD_BITS - shift);
+    }
+}
+
+
+/// \brief Unpack count values of the given width, starting at bit 0 of words.
+///
+/// This is a scalar loop. Values never span more than two words, so each
+/// one is a shift and mask of at most two loads.
+void unpackBits(const uint64_t* words, std::size_t count, uint8_t bits, uint64_t* values)
+{
+    if (bits == 0)
+    {
+        std::fill(values, values + count, 0);
+        return;
+    }
+
+    uint64_t mask = bits == WORD_BITS ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+    std::size_t position = 0;
+
+    for (std::size_t i = 0; i < count; ++i, position += bits)
+    {
+        std::size_t word = position / WORD_BITS;
+        std::size_t shift = position % WORD_BITS;
+
+        uint64_t value = words[word] >> shift;
+
+        if (shift + bits > WORD_BITS)
+            value |= words[word + 1] << (WORD_BITS - shift);
+
+        values[i] = value & mask;
+    }
+}
+
+
+/// \returns the number of words used by count values of the given width.
+std::size_t wordsFor(std::size_t count, uint8_t bits)
+{
+    return (count * bits + WORD_BITS - 1) / WORD_BITS;
+}
+
+
+} // namespace
+
+
+class CompressedIndexRangeList::Cursor
+{
+public:
+    Cursor(const CompressedIndexRangeList& list): _list(list)
+    {
+        _load(0);
+    }
+
+    bool valid() const
+    {
+        return _position < _count;
+    }
+
+    const IndexRange& range() const
+    {
+        return _buffer[_position];
+    }
+
+    void next()
+    {
+        if (++_position == _count)
+            _load(_block + 1);
+    }
+
+private:
+    void _load(std::size_t block)
+    {
+        _block = block;
+        _position = 0;
+        _count = block < _list._numDecodable() ? _list._decode(block, _buffer) : 0;
+    }
+
+    const CompressedIndexRangeList& _list;
+    IndexRange _buffer[BLOCK_SIZE];
+    std::size_t _block = 0;
+    std::size_t _position = 0;
+    std::size_t _count = 0;
+
+};
+
+
+CompressedIndexRangeList::CompressedIndexRangeList()
+{
+}
+
+
+CompressedIndexRangeList::CompressedIndexRangeList(const IndexRangeList& list)
+{
+    for (auto& range: list.ranges())
+        append(range);
+}
+
+
+bool CompressedIndexRangeList::append(const IndexRange& _range)
+{
+    IndexRange range = IndexRangeList::validate(_range);
+
+    if (range.empty())
+        return true;
+
+    if (!_tail.empty())
+    {
+        IndexRange& last = _tail.back();
+
+        if (range.location < last.location)
+        {
+            ofLogError("CompressedIndexRangeList::append") << "Ranges must be appended in order.";
+            return false;
+        }
+
+        if (range.location <= last.getMax())
+        {
+            if (range.getMax() > last.getMax())
+            {
+                _cardinality += range.getMax() - last.getMax();
+                last.setMax(range.getMax());
+            }
+
+            return true;
+        }
+
+        // The last range can no longer grow, so a full tail can be sealed.
+        if (_tail.size() == BLOCK_SIZE)
+            _seal();
+    }
+
+    _tail.push_back(range);
+    _cardinality += range.size;
+    ++_size;
+    return true;
+}
+
+
+void CompressedIndexRangeList::clear()
+{
+    _blocks.clear();
+    _starts.clear();
+    _words.clear();
+    _tail.clear();
+    _size = 0;
+    _cardinality = 0;
+}
+
+
+bool CompressedIndexRangeList::empty() const
+{
+    return _size == 0;
+}
+
+
+std::size_t CompressedIndexRangeList::size() const
+{
+    return _size;
+}
+
+
+std::size_t CompressedIndexRangeList::cardinality() const
+{
+    return _cardinality;
+}
+
+
+std::size_t CompressedIndexRangeList::numBlocks() const
+{
+    return _blocks.size();
+}
+
+
+bool CompressedIndexRangeList::contains(std::size_t index) const
+{
+    IndexRange range = lowerBound(index);
+    return range.contains(index);
+}
+
+
+IndexRange CompressedIndexRangeList::lowerBound(std::size_t index) const
+{
+    std::size_t block = _findBlock(index);
+
+    // The index is before the first range.
+    if (block == _numDecodable())
+        block = 0;
+
+    IndexRange buffer[BLOCK_SIZE];
+
+    // The range may be the first range of the next block.
+    for (; block < _numDecodable(); ++block)
+    {
+        std::size_t count = _decode(block, buffer);
+
+        IndexRange* iter = std::upper_bound(buffer,
+                                            buffer + count,
+                                            index,
+                                            [](std::size_t i, const IndexRange& range) {
+                                                return i < range.getMax();
+                                            });
+
+        if (iter != buffer + count)
+            return *iter;
+    }
+
+    return IndexRange(IndexRange::MAX, 0);
+}
+
+
+void CompressedIndexRangeList::forEach(const std::function<void(const IndexRange&)>& function) const
+{
+    for (Cursor cursor(*this); cursor.valid(); cursor.next())
+        function(cursor.range());
+}
+
+
+std::vector<IndexRange> CompressedIndexRangeList::ranges() const
+{
+    std::vector<IndexRange> results;
+    results.reserve(_size);
+
+    forEach([&](const IndexRange& range) {
+        results.push_back(range);
+    });
+
+    return results;
+}
+
+
+IndexRangeList CompressedIndexRangeList::toList() const
+{
+    IndexRangeList results;
+
+    forEach([&](const IndexRange& range) {
+        results.add(range);
+    });
+
+    return results;
+}
+
+
+CompressedIndexRangeList CompressedIndexRangeList::unionWith(const CompressedIndexRangeList& other) const
+{
+    CompressedIndexRangeList result;
+
+    Cursor a(*this);
+    Cursor b(other);
+
+    while (a.valid() || b.valid())
+    {
+        if (!b.valid() || (a.valid() && a.range().location <= b.range().location))
+        {
+            result.append(a.range());
+            a.next();
+        }
+        else
+        {
+            result.append(b.range());
+            b.next();
+        }
+    }
+
+    return result;
+}
+
+
+CompressedIndexRangeList CompressedIndexRangeList::intersectionWith(const CompressedIndexRangeList& other) const
+{
+    CompressedIndexRangeList result;
+
+    Cursor a(*this);
+    Cursor b(other);
+
+    while (a.valid() && b.valid())
+    {
+        IndexRange intersection = a.range().intersectionWith(b.range());
+
+        if (!intersection.empty())
+            result.append(intersection);
+
+        if (a.range().getMax() < b.range().getMax())
+            a.next();
+        else
+            b.next();
+    }
+
+    return result;
+}
+
+
+CompressedIndexRangeList CompressedIndexRangeList::differenceWith(const CompressedIndexRangeList& other) const
+{
+    CompressedIndexRangeList result;
+
+    Cursor b(other);
+
+    for (Cursor a(*this); a.valid(); a.next())
+    {
+        std::size_t location = a.range().location;
+        std::size_t max = a.range().getMax();
+
+        while (b.valid() && b.range().getMax() <= location)
+            b.next();
+
+        // A range of b that runs past max may also cover the next range.
+        while (b.valid() && b.range().location < max)
+        {
+            if (b.range().location > location)
+                result.append(IndexRange::fromExclusiveInterval(location, b.range().location));
+
+            location = std::max(location, b.range().getMax());
+
+            if (b.range().getMax() >= max)
+                break;
+
+            b.next();
+        }
+
+        if (location < max)
+            result.append(IndexRange::fromExclusiveInterval(location, max));
+    }
+
+    return result;
+}
+
+
+bool CompressedIndexRangeList::operator == (const CompressedIndexRangeList& other) const
+{
+    if (_size != other._size || _cardinality != other._cardinality)
+        return false;
+
+    Cursor a(*this);
+    Cursor b(other);
+
+    for (; a.valid() && b.valid(); a.next(), b.next())
+    {
+        if (a.range() != b.range())
+            return false;
+    }
+
+    return true;
+}
+
+
+bool CompressedIndexRangeList::operator != (const CompressedIndexRangeList& other) const
+{
+    return !(*this == other);
+}
+
+
+std::size_t CompressedIndexRangeList::sizeInBytes() const
+{
+    return sizeof(CompressedIndexRangeList)
+         + _blocks.capacity() * sizeof(Block)
+         + _starts.capacity() * sizeof(std::size_t)
+         + _words.capacity() * sizeof(uint64_t)
+         + _tail.capacity() * sizeof(IndexRange);
+}
+
+
+void CompressedIndexRangeList::_seal()
+{
+    uint64_t gaps[BLOCK_SIZE];
+    uint64_t sizes[BLOCK_SIZE];
+    uint64_t gapBits = 0;
+    uint64_t sizeBits = 0;
+
+    std::size_t count = _tail.size();
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        gaps[i] = i > 0 ? _tail[i].location - _tail[i - 1].getMax() : 0;
+        sizes[i] = _tail[i].size - 1;
+        gapBits |= gaps[i];
+        sizeBits |= sizes[i];
+    }
+
+    Block block;
+    block.wordOffset = _words.size();
+    block.count = static_cast<uint16_t>(count);
+    block.gapBits = bitsFor(gapBits);
+    block.sizeBits = bitsFor(sizeBits);
+
+    std::size_t gapWords = wordsFor(count, block.gapBits);
+    std::size_t sizeWords = wordsFor(count, block.sizeBits);
+
+    _words.resize(_words.size() + gapWords + sizeWords, 0);
+    packBits(gaps, count, block.gapBits, _words.data() + block.wordOffset);
+    packBits(sizes, count, block.sizeBits, _words.data() + block.wordOffset + gapWords);
+
+    _blocks.push_back(block);
+    _starts.push_back(_tail.front().location);
+    _tail.clear();
+}
+
+
+std::size_t CompressedIndexRangeList::_numDecodable() const
+{
+    return _blocks.size() + (_tail.empty() ? 0 : 1);
+}
+
+
+std::size_t CompressedIndexRangeList::_decode(std::size_t index, IndexRange* output) const
+{
+    if (index == _blocks.size())
+    {
+        std::copy(_tail.begin(), _tail.end(), output);
+        return _tail.size();
+    }
+
+    const Block& block = _blocks[index];
+
+    uint64_t gaps[BLOCK_SIZE];
+    uint64_t sizes[BLOCK_SIZE];
+
+    const uint64_t* words = _words.data() + block.wordOffset;
+    unpackBits(words, block.count, block.gapBits, gaps);
+    unpackBits(words + wordsFor(block.count, block.gapBits), block.count, block.sizeBits, sizes);
+
+    std::size_t location = _starts[index];
+
+    for (std::size_t i = 0; i < block.count; ++i)
+    {
+        location += gaps[i];
+        output[i] = IndexRange(location, sizes[i] + 1);
+        location += output[i].size;
+    }
+
+    return block.count;
+}
+
+
+std::size_t CompressedIndexRangeList::_findBlock(std::size_t index) const
+{
+    // The tail is not in the skip index.
+    if (!_tail.empty() && _tail.front().location <= index)
+        return _blocks.size();
+
+    auto iter = std::upper_bound(_starts.begin(), _starts.end(), index);
+
+    if (iter != _starts.begin())
+        return (iter - _starts.begin()) - 1;
+
+    return _numDecodable();
+}
+
+
+} // namespace ofx
@@ -0,0 +1,272 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/IndexRangeCache.h"
+#include <algorithm>
+
+
+namespace ofx {
+
+
+IndexRangeCache::IndexRangeCache()
+{
+}
+
+
+IndexRangeCache::IndexRangeCache(std::size_t capacity):
+    _capacity(capacity)
+{
+}
+
+
+void IndexRangeCache::insert(std::size_t location, const uint8_t* data, std::size_t size)
+{
+    IndexRange range = IndexRangeList::validate(IndexRange(location, std::min(size, _capacity)));
+
+    if (range.empty())
+        return;
+
+    erase(range);
+
+    std::vector<uint8_t> merged;
+    std::size_t mergedLocation = range.location;
+
+    // Trim the neighbours first if the merged chunk would not fit.
+    std::size_t excess = 0;
+
+    auto left = _chunks.end();
+    auto right = _chunks.find(range.getMax());
+
+    auto next = _chunks.lower_bound(range.location);
+
+    if (next != _chunks.begin())
+    {
+        auto previous = std::prev(next);
+
+        if (previous->first + previous->second.data.size() == range.location)
+            left = previous;
+    }
+
+    std::size_t leftSize = left != _chunks.end() ? left->second.data.size() : 0;
+    std::size_t rightSize = right != _chunks.end() ? right->second.data.size() : 0;
+
+    if (leftSize + rightSize > _capacity - range.size)
+        excess = leftSize + rightSize - (_capacity - range.size);
+
+    std::size_t leftDrop = std::min(excess, leftSize);
+    std::size_t rightDrop = excess - leftDrop;
+
+    merged.reserve(leftSize + range.size + rightSize - excess);
+
+    if (left != _chunks.end())
+    {
+        mergedLocation = left->first + leftDrop;
+        merged.insert(merged.end(), left->second.data.begin() + leftDrop, left->second.data.end());
+        _remove(left);
+    }
+
+    merged.insert(merged.end(), data, data + range.size);
+
+    if (right != _chunks.end())
+    {
+        merged.insert(merged.end(), right->second.data.begin(), right->second.data.end() - rightDrop);
+        _remove(right);
+    }
+
+    _size += merged.size();
+
+    Chunk& chunk = _chunks[mergedLocation];
+    chunk.data = std::move(merged);
+    chunk.lru = _lru.insert(_lru.begin(), mergedLocation);
+
+    _evict(mergedLocation);
+}
+
+
+void IndexRangeCache::insert(std::size_t location, const std::vector<uint8_t>& data)
+{
+    insert(location, data.data(), data.size());
+}
+
+
+IndexRangeCacheLookup IndexRangeCache::lookup(const IndexRange& _range)
+{
+    IndexRangeCacheLookup result;
+
+    IndexRange range = IndexRangeList::validate(_range);
+
+    if (range.empty())
+        return result;
+
+    std::size_t position = range.location;
+
+    for (auto iter = _firstEndingAfter(range.location);
+         iter != _chunks.end() && iter->first < range.getMax();
+         ++iter)
+    {
+        IndexRange chunkRange(iter->first, iter->second.data.size());
+
+        if (chunkRange.location > position)
+            result.missing.add(IndexRange::fromExclusiveInterval(position, chunkRange.location));
+
+        IndexRangeCachePiece piece;
+        piece.range = chunkRange.intersectionWith(range);
+        piece.data = iter->second.data.data() + (piece.range.location - chunkRange.location);
+        result.pieces.push_back(piece);
+
+        position = piece.range.getMax();
+        _touch(iter);
+    }
+
+    if (position < range.getMax())
+        result.missing.add(IndexRange::fromExclusiveInterval(position, range.getMax()));
+
+    return result;
+}
+
+
+void IndexRangeCache::erase(const IndexRange& _range)
+{
+    IndexRange range = IndexRangeList::validate(_range);
+
+    if (range.empty())
+        return;
+
+    auto iter = _firstEndingAfter(range.location);
+
+    while (iter != _chunks.end() && iter->first < range.getMax())
+    {
+        std::size_t location = iter->first;
+        std::size_t max = location + iter->second.data.size();
+
+        // The part after the range keeps the recency of the original chunk.
+        if (max > range.getMax())
+        {
+            std::size_t offset = range.getMax() - location;
+            Chunk& right = _chunks[range.getMax()];
+            right.data.assign(iter->second.data.begin() + offset, iter->second.data.end());
+            right.lru = _lru.insert(std::next(iter->second.lru), range.getMax());
+            _size += right.data.size();
+        }
+
+        if (location < range.location)
+        {
+            std::size_t trimmed = max - range.location;
+            iter->second.data.resize(range.location - location);
+            _size -= trimmed;
+            ++iter;
+        }
+        else
+        {
+            iter = _remove(iter);
+        }
+    }
+}
+
+
+void IndexRangeCache::clear()
+{
+    _chunks.clear();
+    _lru.clear();
+    _size = 0;
+}
+
+
+bool IndexRangeCache::empty() const
+{
+    return _chunks.empty();
+}
+
+
+std::size_t IndexRangeCache::size() const
+{
+    return _size;
+}
+
+
+std::size_t IndexRangeCache::numChunks() const
+{
+    return _chunks.size();
+}
+
+
+std::size_t IndexRangeCache::capacity() const
+{
+    return _capacity;
+}
+
+
+void IndexRangeCache::setCapacity(std::size_t capacity)
+{
+    _capacity = capacity;
+    _evict(IndexRange::MAX);
+}
+
+
+IndexRangeList IndexRangeCache::cached() const
+{
+    IndexRangeList results;
+
+    for (auto& chunk: _chunks)
+        results.add(IndexRange(chunk.first, chunk.second.data.size()));
+
+    return results;
+}
+
+
+IndexRangeCache::ChunkMap::iterator IndexRangeCache::_firstEndingAfter(std::size_t location)
+{
+    auto iter = _chunks.upper_bound(location);
+
+    if (iter != _chunks.begin())
+    {
+        auto previous = std::prev(iter);
+
+        if (previous->first + previous->second.data.size() > location)
+            return previous;
+    }
+
+    return iter;
+}
+
+
+void IndexRangeCache::_touch(ChunkMap::iterator chunk)
+{
+    _lru.splice(_lru.begin(), _lru, chunk->second.lru);
+}
+
+
+IndexRangeCache::ChunkMap::iterator IndexRangeCache::_remove(ChunkMap::iterator chunk)
+{
+    _size -= chunk->second.data.size();
+    _lru.erase(chunk->second.lru);
+    return _chunks.erase(chunk);
+}
+
+
+void IndexRangeCache::_evict(std::size_t keep)
+{
+    while (_size > _capacity && !_lru.empty())
+    {
+        std::size_t location = _lru.back();
+
+        // The kept chunk always fits on its own, see insert().
+        if (location == keep)
+        {
+            if (_lru.size() == 1)
+                return;
+
+            _lru.splice(_lru.begin(), _lru, std::prev(_lru.end()));
+            continue;
+        }
+
+        _remove(_chunks.find(location));
+    }
+}
+
+
+} // namespace ofx
@@ -0,0 +1,125 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/IndexRangeDirtyTracker.h"
+#include <cstring>
+
+
+namespace ofx {
+
+
+IndexRangeDirtyTracker::IndexRangeDirtyTracker():
+    IndexRangeDirtyTracker(Settings())
+{
+}
+
+
+IndexRangeDirtyTracker::IndexRangeDirtyTracker(const Settings& settings):
+    _settings(settings)
+{
+}
+
+
+void IndexRangeDirtyTracker::add(const IndexRange& _range)
+{
+    IndexRange range = IndexRangeList::validate(_range);
+
+    if (range.empty())
+        return;
+
+    std::size_t granularity = std::max(std::size_t(1), _settings.granularity);
+
+    if (granularity > 1)
+    {
+        std::size_t min = range.getMin() - (range.getMin() % granularity);
+        std::size_t max = range.getMax();
+        std::size_t remainder = max % granularity;
+
+        if (remainder != 0)
+        {
+            std::size_t snapped = max + (granularity - remainder);
+            max = snapped < max ? IndexRange::MAX : snapped;
+        }
+
+        range = IndexRange::fromExclusiveInterval(min, max);
+    }
+
+    _dirty.add(range);
+}
+
+
+void IndexRangeDirtyTracker::clear()
+{
+    _dirty.clear();
+}
+
+
+bool IndexRangeDirtyTracker::empty() const
+{
+    return _dirty.empty();
+}
+
+
+std::size_t IndexRangeDirtyTracker::dirtyBytes() const
+{
+    return _dirty.cardinality();
+}
+
+
+const IndexRangeList& IndexRangeDirtyTracker::dirty() const
+{
+    return _dirty;
+}
+
+
+const IndexRangeDirtyTracker::Settings& IndexRangeDirtyTracker::settings() const
+{
+    return _settings;
+}
+
+
+std::vector<IndexRange> IndexRangeDirtyTracker::plan(std::size_t size) const
+{
+    IndexRangeCoalesceSettings settings;
+    settings.maxGap = _settings.copyOverhead;
+
+    std::vector<IndexRange> results;
+
+    for (auto& request: _dirty.coalesce(settings))
+    {
+        IndexRange span = request.range.intersectionWith(IndexRange(0, size));
+
+        if (!span.empty())
+            results.push_back(span);
+    }
+
+    return results;
+}
+
+
+std::size_t IndexRangeDirtyTracker::flush(const void* source,
+                                          void* destination,
+                                          std::size_t size)
+{
+    const uint8_t* src = static_cast<const uint8_t*>(source);
+    uint8_t* dst = static_cast<uint8_t*>(destination);
+
+    std::size_t result = 0;
+
+    for (auto& span: plan(size))
+    {
+        std::memcpy(dst + span.location, src + span.location, span.size);
+        result += span.size;
+    }
+
+    clear();
+
+    return result;
+}
+
+
+} // namespace ofx
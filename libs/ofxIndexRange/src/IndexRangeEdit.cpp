@@ -0,0 +1,50 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/IndexRangeEdit.h"
+
+
+namespace ofx {
+
+
+IndexRangeEdit::IndexRangeEdit()
+{
+}
+
+
+IndexRangeEdit::IndexRangeEdit(Type _type, const IndexRange& _range):
+    type(_type),
+    range(_range)
+{
+}
+
+
+bool IndexRangeEdit::operator == (const IndexRangeEdit& other) const
+{
+    return type == other.type && range == other.range;
+}
+
+
+bool IndexRangeEdit::operator != (const IndexRangeEdit& other) const
+{
+    return !(*this == other);
+}
+
+
+IndexRangeEdit IndexRangeEdit::insert(const IndexRange& range)
+{
+    return IndexRangeEdit(Type::INSERT, range);
+}
+
+
+IndexRangeEdit IndexRangeEdit::erase(const IndexRange& range)
+{
+    return IndexRangeEdit(Type::ERASE, range);
+}
+
+
+} // namespace ofx
@@ -0,0 +1,458 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/IndexRangeFileReader.h"
+#include "ofx/IndexRangeParallel.h"
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <limits>
+#include "ofConstants.h"
+#include "ofLog.h"
+
+#if defined(TARGET_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#if defined(__APPLE__)
+#include <Availability.h>
+#endif
+
+
+// preadv() was added in macOS 11, iOS 14 and Android API 24. Older targets
+// fall back to a pread() per wanted segment.
+#if !defined(OFX_INDEX_RANGE_HAVE_PREADV)
+    #if defined(TARGET_WIN32)
+        #define OFX_INDEX_RANGE_HAVE_PREADV 0
+    #elif defined(__APPLE__)
+        // The SDK only declares preadv() from these versions on.
+        #if defined(__MAC_11_0) || defined(__IPHONE_14_0)
+            #define OFX_INDEX_RANGE_HAVE_PREADV 1
+        #else
+            #define OFX_INDEX_RANGE_HAVE_PREADV 0
+        #endif
+    #elif defined(__ANDROID__) && __ANDROID_API__ < 24
+        #define OFX_INDEX_RANGE_HAVE_PREADV 0
+    #else
+        #define OFX_INDEX_RANGE_HAVE_PREADV 1
+    #endif
+#endif
+
+
+namespace ofx {
+
+
+namespace {
+
+
+/// \brief The largest file offset that can be passed to a read.
+#if defined(TARGET_WIN32)
+const uint64_t MAX_OFFSET = std::numeric_limits<__int64>::max();
+#else
+const uint64_t MAX_OFFSET = std::numeric_limits<off_t>::max();
+#endif
+
+
+/// \brief A contiguous part of a request.
+struct Segment
+{
+    /// \brief The destination, or nullptr if the bytes are discarded.
+    uint8_t* data = nullptr;
+
+    /// \brief The number of bytes.
+    std::size_t size = 0;
+
+};
+
+
+/// \brief A single vectored read.
+struct Job
+{
+    /// \brief The file offset of the first segment.
+    std::size_t offset = 0;
+
+    /// \brief The number of bytes up to the end of the last wanted segment.
+    ///
+    /// Reads may end early after this, e.g. when alignment padding extends
+    /// past the end of the file.
+    std::size_t required = 0;
+
+    /// \brief The segments of the read, in file order.
+    std::vector<Segment> segments;
+
+};
+
+
+/// \brief Turn coalesced requests into jobs.
+/// \param requests The coalesced requests.
+/// \param destination Returns the destination of a sub-range.
+/// \param maxHole Set to the size of the largest discarded segment.
+template <typename Destination>
+std::vector<Job> makeJobs(const std::vector<IndexRangeRequest>& requests,
+                          Destination destination,
+                          std::size_t& maxHole)
+{
+    std::vector<Job> jobs;
+    jobs.reserve(requests.size());
+    maxHole = 0;
+
+    for (auto& request: requests)
+    {
+        Job job;
+        job.offset = request.range.location;
+
+        std::size_t position = request.range.location;
+
+        auto addHole = [&](std::size_t size) {
+            if (size > 0)
+            {
+                job.segments.push_back({ nullptr, size });
+                maxHole = std::max(maxHole, size);
+            }
+        };
+
+        for (auto& range: request.ranges)
+        {
+            addHole(range.location - position);
+            job.segments.push_back({ destination(range), range.size });
+            position = range.getMax();
+        }
+
+        job.required = position - job.offset;
+        addHole(request.range.getMax() - position);
+        jobs.push_back(std::move(job));
+    }
+
+    return jobs;
+}
+
+
+#if defined(TARGET_WIN32)
+
+
+bool readJob(int fd, const Job& job, uint8_t* discard)
+{
+    if (_lseeki64(fd, job.offset, SEEK_SET) < 0)
+    {
+        ofLogError("IndexRangeFileReader::read") << "Seek failed: " << std::strerror(errno);
+        return false;
+    }
+
+    std::size_t done = 0;
+
+    for (auto& segment: job.segments)
+    {
+        uint8_t* data = segment.data != nullptr ? segment.data : discard;
+        std::size_t remaining = segment.size;
+
+        while (remaining > 0 && done < job.required)
+        {
+            unsigned count = unsigned(std::min<std::size_t>(remaining, INT_MAX));
+            int n = _read(fd, data, count);
+
+            if (n < 0)
+            {
+                ofLogError("IndexRangeFileReader::read") << "Read failed: " << std::strerror(errno);
+                return false;
+            }
+
+            if (n == 0)
+                return done >= job.required;
+
+            data += n;
+            remaining -= n;
+            done += n;
+        }
+    }
+
+    return done >= job.required;
+}
+
+
+#else
+
+
+/// \brief Read the wanted segments of a job with one pread() each.
+///
+/// The holes are skipped, so no bytes are discarded.
+bool preadJob(int fd, const Job& job)
+{
+    std::size_t offset = job.offset;
+
+    for (auto& segment: job.segments)
+    {
+        std::size_t done = 0;
+
+        while (segment.data != nullptr && done < segment.size)
+        {
+            std::size_t count = std::min<std::size_t>(segment.size - done, SSIZE_MAX);
+            ssize_t n = ::pread(fd, segment.data + done, count, off_t(offset + done));
+
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                ofLogError("IndexRangeFileReader::read") << "Read failed: " << std::strerror(errno);
+                return false;
+            }
+
+            // Every wanted segment ends before job.required.
+            if (n == 0)
+                return false;
+
+            done += n;
+        }
+
+        offset += segment.size;
+    }
+
+    return true;
+}
+
+
+#if OFX_INDEX_RANGE_HAVE_PREADV
+
+
+/// \brief Read a job with vectored reads.
+bool preadvJob(int fd, const Job& job, uint8_t* discard)
+{
+#if defined(IOV_MAX)
+    const std::size_t maxVectors = IOV_MAX;
+#else
+    const std::size_t maxVectors = 1024;
+#endif
+
+    std::vector<iovec> vectors(job.segments.size());
+
+    for (std::size_t i = 0; i < job.segments.size(); ++i)
+    {
+        const Segment& segment = job.segments[i];
+        vectors[i].iov_base = segment.data != nullptr ? segment.data : discard;
+        vectors[i].iov_len = segment.size;
+    }
+
+    std::size_t first = 0;
+    std::size_t done = 0;
+
+    while (first < vectors.size() && done < job.required)
+    {
+        int count = int(std::min(vectors.size() - first, maxVectors));
+        ssize_t n = ::preadv(fd, &vectors[first], count, off_t(job.offset + done));
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            ofLogError("IndexRangeFileReader::read") << "Read failed: " << std::strerror(errno);
+            return false;
+        }
+
+        // End of file.
+        if (n == 0)
+            break;
+
+        done += n;
+
+        // Skip the vectors that were filled and trim a partially filled one.
+        std::size_t remaining = n;
+
+        while (remaining > 0 && first < vectors.size())
+        {
+            if (remaining >= vectors[first].iov_len)
+            {
+                remaining -= vectors[first].iov_len;
+                ++first;
+            }
+            else
+            {
+                vectors[first].iov_base = static_cast<uint8_t*>(vectors[first].iov_base) + remaining;
+                vectors[first].iov_len -= remaining;
+                remaining = 0;
+            }
+        }
+    }
+
+    return done >= job.required;
+}
+
+
+#endif
+
+
+bool readJob(int fd, const Job& job, uint8_t* discard)
+{
+#if OFX_INDEX_RANGE_HAVE_PREADV
+#if defined(__APPLE__)
+    if (__builtin_available(macOS 11.0, iOS 14.0, tvOS 14.0, watchOS 7.0, *))
+        return preadvJob(fd, job, discard);
+#else
+    return preadvJob(fd, job, discard);
+#endif
+#endif
+
+    (void)discard;
+    return preadJob(fd, job);
+}
+
+
+#endif
+
+
+bool readJobs(int fd,
+              const std::vector<Job>& jobs,
+              std::size_t maxHole,
+              const IndexRangeFileReader::Settings& settings)
+{
+#if defined(TARGET_WIN32)
+    // The file position is shared, so reads must be sequential.
+    std::size_t numSlots = 1;
+    (void)settings;
+#else
+    std::size_t numSlots = settings.numThreads;
+
+    if (numSlots == 0)
+        numSlots = IndexRangeParallel::numThreads();
+#endif
+
+    numSlots = std::max(std::size_t(1), std::min(numSlots, jobs.size()));
+
+    std::atomic<std::size_t> next(0);
+    std::atomic<bool> success(true);
+
+    // Each slot pulls jobs until none are left and reads the holes into its
+    // own scratch buffer. Slots run on the IndexRangeParallel pool, so no
+    // threads are created per call. A slot that starts after the jobs run
+    // out returns without allocating.
+    IndexRangeParallel::forEach(numSlots, [&](std::size_t) {
+        std::vector<uint8_t> discard;
+
+        for (std::size_t i = next++; i < jobs.size() && success; i = next++)
+        {
+            if (discard.empty())
+                discard.resize(std::max(std::size_t(1), maxHole));
+
+            if (!readJob(fd, jobs[i], discard.data()))
+                success = false;
+        }
+    });
+
+    if (!success)
+        ofLogError("IndexRangeFileReader::read") << "Unable to read all ranges.";
+
+    return success;
+}
+
+
+/// \returns true if every covered byte of the list has a valid file offset.
+bool checkOffsets(const IndexRangeList& list)
+{
+    if (!list.empty() && list.back().getMax() - 1 > MAX_OFFSET)
+    {
+        ofLogError("IndexRangeFileReader::read") << "Range " << list.back() << " is past the largest file offset.";
+        return false;
+    }
+
+    return true;
+}
+
+
+} // namespace
+
+
+bool IndexRangeFileReader::read(int fd,
+                                const IndexRangeList& list,
+                                uint8_t* output,
+                                const Settings& settings)
+{
+    if (!checkOffsets(list))
+        return false;
+
+    std::size_t offset = 0;
+
+    auto destination = [&](const IndexRange& range) {
+        uint8_t* result = output + offset;
+        offset += range.size;
+        return result;
+    };
+
+    std::size_t maxHole = 0;
+    auto jobs = makeJobs(list.coalesce(settings.coalesce), destination, maxHole);
+    return readJobs(fd, jobs, maxHole, settings);
+}
+
+
+bool IndexRangeFileReader::read(int fd,
+                                const IndexRangeList& list,
+                                const std::vector<uint8_t*>& buffers,
+                                const Settings& settings)
+{
+    if (!checkOffsets(list))
+        return false;
+
+    std::vector<IndexRange> ranges = list.ranges();
+
+    if (buffers.size() < ranges.size())
+    {
+        ofLogError("IndexRangeFileReader::read") << "Expected " << ranges.size() << " buffers, got " << buffers.size() << ".";
+        return false;
+    }
+
+    // Sub-ranges arrive in order, so track the range they were split from.
+    std::size_t index = 0;
+
+    auto destination = [&](const IndexRange& range) {
+        while (range.location >= ranges[index].getMax())
+            ++index;
+
+        return buffers[index] + (range.location - ranges[index].location);
+    };
+
+    std::size_t maxHole = 0;
+    auto jobs = makeJobs(list.coalesce(settings.coalesce), destination, maxHole);
+    return readJobs(fd, jobs, maxHole, settings);
+}
+
+
+bool IndexRangeFileReader::read(const std::string& path,
+                                const IndexRangeList& list,
+                                std::vector<uint8_t>& output,
+                                const Settings& settings)
+{
+#if defined(TARGET_WIN32)
+    int fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+#endif
+
+    if (fd < 0)
+    {
+        ofLogError("IndexRangeFileReader::read") << "Unable to open " << path << ": " << std::strerror(errno);
+        return false;
+    }
+
+    output.resize(list.cardinality());
+    bool result = read(fd, list, output.data(), settings);
+
+#if defined(TARGET_WIN32)
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+
+    return result;
+}
+
+
+} // namespace ofx
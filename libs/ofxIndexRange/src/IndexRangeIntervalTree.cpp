@@ -0,0 +1,307 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/IndexRangeIntervalTree.h"
+#include <algorithm>
+#include "ofx/IndexRangeList.h"
+
+
+namespace ofx {
+
+
+namespace {
+
+
+/// \brief Subtrees at or below this level are scanned linearly.
+const std::size_t SCAN_LEVEL = 3;
+
+
+} // namespace
+
+
+IndexRangeIntervalTree::IndexRangeIntervalTree()
+{
+}
+
+
+void IndexRangeIntervalTree::add(const IndexRange& range, std::size_t id)
+{
+    Node node;
+    node.interval.range = IndexRangeList::validate(range);
+    node.interval.id = id;
+    _nodes.push_back(node);
+    _indexed = false;
+}
+
+
+std::size_t IndexRangeIntervalTree::remove(std::size_t id)
+{
+    std::size_t size = _nodes.size();
+
+    _nodes.erase(std::remove_if(_nodes.begin(), _nodes.end(), [&](const Node& node) {
+        return node.interval.id == id;
+    }), _nodes.end());
+
+    // The order is kept, but the subtree ends must be rebuilt.
+    if (_nodes.size() != size)
+        _indexed = false;
+
+    return size - _nodes.size();
+}
+
+
+void IndexRangeIntervalTree::clear()
+{
+    _nodes.clear();
+    _indexed = true;
+    _rootLevel = 0;
+}
+
+
+bool IndexRangeIntervalTree::empty() const
+{
+    return _nodes.empty();
+}
+
+
+std::size_t IndexRangeIntervalTree::size() const
+{
+    return _nodes.size();
+}
+
+
+std::vector<IndexRangeInterval> IndexRangeIntervalTree::intervals() const
+{
+    _index();
+
+    std::vector<IndexRangeInterval> results;
+    results.reserve(_nodes.size());
+
+    for (auto& node: _nodes)
+        results.push_back(node.interval);
+
+    return results;
+}
+
+
+std::vector<IndexRangeInterval> IndexRangeIntervalTree::stab(std::size_t index) const
+{
+    if (index == IndexRange::MAX)
+        return std::vector<IndexRangeInterval>();
+
+    return overlapping(IndexRange(index, 1));
+}
+
+
+std::vector<IndexRangeInterval> IndexRangeIntervalTree::overlapping(const IndexRange& range) const
+{
+    std::vector<IndexRangeInterval> results;
+
+    forEachOverlapping(range, [&](const IndexRangeInterval& interval) {
+        results.push_back(interval);
+    });
+
+    return results;
+}
+
+
+void IndexRangeIntervalTree::forEachOverlapping(const IndexRange& _range,
+                                                const std::function<void(const IndexRangeInterval&)>& function) const
+{
+    IndexRange range = IndexRangeList::validate(_range);
+
+    if (range.empty())
+        return;
+
+    _index();
+
+    if (_nodes.empty())
+        return;
+
+    _query((std::size_t(1) << _rootLevel) - 1,
+           _rootLevel,
+           range.getMin(),
+           range.getMax(),
+           function);
+}
+
+
+void IndexRangeIntervalTree::join(const IndexRangeIntervalTree& other,
+                                  const std::function<void(const IndexRangeInterval&, const IndexRangeInterval&)>& function) const
+{
+    _index();
+    other._index();
+
+    // The intervals that started before the sweep position, per side.
+    std::vector<const IndexRangeInterval*> aActive;
+    std::vector<const IndexRangeInterval*> bActive;
+
+    // Drop the intervals that end at or before location while reporting
+    // the others. Each interval is dropped once and every other visit
+    // reports a pair.
+    auto report = [](std::vector<const IndexRangeInterval*>& active,
+                     std::size_t location,
+                     const std::function<void(const IndexRangeInterval*)>& f) {
+        std::size_t count = 0;
+
+        for (auto interval: active)
+        {
+            if (interval->range.getMax() > location)
+            {
+                f(interval);
+                active[count++] = interval;
+            }
+        }
+
+        active.resize(count);
+    };
+
+    auto aIter = _nodes.begin();
+    auto bIter = other._nodes.begin();
+
+    while (aIter != _nodes.end() || bIter != other._nodes.end())
+    {
+        bool fromA = bIter == other._nodes.end()
+                  || (aIter != _nodes.end() && aIter->interval.range.location <= bIter->interval.range.location);
+
+        const IndexRangeInterval& interval = fromA ? (aIter++)->interval : (bIter++)->interval;
+
+        if (interval.range.empty())
+            continue;
+
+        if (fromA)
+        {
+            report(bActive, interval.range.location, [&](const IndexRangeInterval* b) {
+                function(interval, *b);
+            });
+
+            aActive.push_back(&interval);
+        }
+        else
+        {
+            report(aActive, interval.range.location, [&](const IndexRangeInterval* a) {
+                function(*a, interval);
+            });
+
+            bActive.push_back(&interval);
+        }
+    }
+}
+
+
+std::vector<std::pair<std::size_t, std::size_t>> IndexRangeIntervalTree::join(const IndexRangeIntervalTree& other) const
+{
+    std::vector<std::pair<std::size_t, std::size_t>> results;
+
+    join(other, [&](const IndexRangeInterval& a, const IndexRangeInterval& b) {
+        results.push_back(std::make_pair(a.id, b.id));
+    });
+
+    return results;
+}
+
+
+void IndexRangeIntervalTree::_index() const
+{
+    if (_indexed)
+        return;
+
+    std::sort(_nodes.begin(), _nodes.end(), [](const Node& a, const Node& b) {
+        if (a.interval.range.location != b.interval.range.location)
+            return a.interval.range.location < b.interval.range.location;
+
+        if (a.interval.range.size != b.interval.range.size)
+            return a.interval.range.size < b.interval.range.size;
+
+        return a.interval.id < b.interval.id;
+    });
+
+    // The smallest complete tree holding all nodes has 2^(level + 1) - 1.
+    _rootLevel = 0;
+
+    while ((std::size_t(2) << _rootLevel) - 1 < _nodes.size())
+        ++_rootLevel;
+
+    if (!_nodes.empty())
+        _build((std::size_t(1) << _rootLevel) - 1, _rootLevel);
+
+    _indexed = true;
+}
+
+
+std::size_t IndexRangeIntervalTree::_build(std::size_t x, std::size_t level) const
+{
+    // The subtree covers [x - 2^level + 1, x + 2^level - 1].
+    std::size_t first = x + 1 - (std::size_t(1) << level);
+
+    if (first >= _nodes.size())
+        return 0;
+
+    std::size_t maxEnd = x < _nodes.size() ? _nodes[x].interval.range.getMax() : 0;
+
+    if (level > 0)
+    {
+        std::size_t half = std::size_t(1) << (level - 1);
+        maxEnd = std::max(maxEnd, _build(x - half, level - 1));
+        maxEnd = std::max(maxEnd, _build(x + half, level - 1));
+    }
+
+    if (x < _nodes.size())
+        _nodes[x].maxEnd = maxEnd;
+
+    return maxEnd;
+}
+
+
+void IndexRangeIntervalTree::_query(std::size_t x,
+                                    std::size_t level,
+                                    std::size_t min,
+                                    std::size_t max,
+                                    const std::function<void(const IndexRangeInterval&)>& function) const
+{
+    std::size_t first = x + 1 - (std::size_t(1) << level);
+
+    if (first >= _nodes.size())
+        return;
+
+    if (level <= SCAN_LEVEL)
+    {
+        std::size_t last = std::min(x + (std::size_t(1) << level), _nodes.size());
+
+        for (std::size_t i = first; i < last && _nodes[i].interval.range.location < max; ++i)
+        {
+            const IndexRange& range = _nodes[i].interval.range;
+
+            if (range.getMax() > min && !range.empty())
+                function(_nodes[i].interval);
+        }
+
+        return;
+    }
+
+    // Nodes past the end have no stored subtree end, so always descend.
+    if (x < _nodes.size() && _nodes[x].maxEnd <= min)
+        return;
+
+    std::size_t half = std::size_t(1) << (level - 1);
+
+    _query(x - half, level - 1, min, max, function);
+
+    // Everything to the right starts at or after this node.
+    if (x < _nodes.size() && _nodes[x].interval.range.location < max)
+    {
+        const IndexRange& range = _nodes[x].interval.range;
+
+        if (range.getMax() > min && !range.empty())
+            function(_nodes[x].interval);
+
+        _query(x + half, level - 1, min, max, function);
+    }
+}
+
+
+} // namespace ofx
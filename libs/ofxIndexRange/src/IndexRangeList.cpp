@@ -6,105 +6,602 @@
 
 
 #include "ofx/IndexRangeList.h"
+#include "ofx/IndexRangeMapper.h"
+#include "ofx/IndexRangeParallel.h"
 #include "ofLog.h"
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 
 namespace ofx {
 
 
-IndexRangeList::IndexRangeList()
+namespace {
+
+
+/// \brief Append a range, merging it with the last range if they touch.
+///
+/// Ranges must be appended in order of their location.
+template <typename Container>
+void appendMerged(Container& ranges, const IndexRange& range)
+{
+    if (range.empty())
+        return;
+
+    if (!ranges.empty() && ranges.back().getMax() >= range.location)
+    {
+        if (range.getMax() > ranges.back().getMax())
+            ranges.back().setMax(range.getMax());
+    }
+    else
+    {
+        ranges.push_back(range);
+    }
+}
+
+
+/// \brief Ranges added this close to the tail of a sorted list are merged
+/// immediately instead of being deferred to _sort().
+const std::size_t NEAR_TAIL_DISTANCE = 32;
+
+
+/// \brief Batches with at least this many ranges are radix sorted.
+const std::size_t RADIX_SORT_THRESHOLD = 1 << 12;
+
+
+/// \brief The number of key bits sorted in each radix pass.
+const std::size_t RADIX_BITS = 11;
+
+
+/// \brief Sort ranges by location with an LSD radix sort.
+///
+/// Ranges with the same location are left in an unspecified order, which is
+/// fine for callers that merge afterwards. Passes where every key has the
+/// same digit are skipped, so small locations only pay for the low digits.
+///
+/// The scratch buffer is kept per thread and reused across calls.
+///
+/// \returns either \p first or the scratch buffer, whichever holds the
+/// sorted ranges.
+const IndexRange* radixSort(IndexRange* first, IndexRange* last)
+{
+    const std::size_t numBuckets = std::size_t(1) << RADIX_BITS;
+    const std::size_t numPasses = (sizeof(std::size_t) * 8 + RADIX_BITS - 1) / RADIX_BITS;
+    const std::size_t mask = numBuckets - 1;
+
+    thread_local std::vector<IndexRange> scratch;
+    thread_local std::vector<std::size_t> counts;
+
+    std::size_t count = last - first;
+
+    if (scratch.size() < count)
+        scratch.resize(count);
+
+    counts.assign(numPasses * numBuckets, 0);
+
+    // Build the histograms of all passes in a single read.
+    for (IndexRange* iter = first; iter != last; ++iter)
+    {
+        std::size_t key = iter->location;
+
+        for (std::size_t pass = 0; pass < numPasses; ++pass)
+            ++counts[pass * numBuckets + ((key >> (pass * RADIX_BITS)) & mask)];
+    }
+
+    IndexRange* source = first;
+    IndexRange* destination = scratch.data();
+
+    for (std::size_t pass = 0; pass < numPasses; ++pass)
+    {
+        std::size_t shift = pass * RADIX_BITS;
+        std::size_t* offsets = &counts[pass * numBuckets];
+
+        // Every key has the same digit.
+        if (offsets[(first->location >> shift) & mask] == count)
+            continue;
+
+        std::size_t offset = 0;
+
+        for (std::size_t bucket = 0; bucket < numBuckets; ++bucket)
+        {
+            std::size_t bucketSize = offsets[bucket];
+            offsets[bucket] = offset;
+            offset += bucketSize;
+        }
+
+        for (std::size_t i = 0; i < count; ++i)
+            destination[offsets[(source[i].location >> shift) & mask]++] = source[i];
+
+        std::swap(source, destination);
+    }
+
+    return source;
+}
+
+
+/// \brief Merge sorted ranges that overlap or are adjacent.
+///
+/// \p output may be equal to \p first to merge in place.
+///
+/// \param cardinality Set to the number of indices covered.
+/// \returns the end of the merged output.
+IndexRange* mergeSorted(const IndexRange* first,
+                        const IndexRange* last,
+                        IndexRange* output,
+                        std::size_t& cardinality)
+{
+    cardinality = 0;
+
+    if (first == last)
+        return output;
+
+    IndexRange current = *first++;
+
+    for (; first != last; ++first)
+    {
+        if (current.getMax() >= first->location)
+        {
+            if (first->getMax() > current.getMax())
+                current.setMax(first->getMax());
+        }
+        else
+        {
+            cardinality += current.size;
+            *output++ = current;
+            current = *first;
+        }
+    }
+
+    cardinality += current.size;
+    *output++ = current;
+    return output;
+}
+
+
+/// \brief Merge two sorted runs, combining ranges that overlap or are
+///        adjacent.
+///
+/// \p output may alias the second run if it starts at or before it, because
+/// the output never passes the next unread range of that run.
+///
+/// \param cardinality Set to the number of indices covered.
+/// \returns the end of the merged output.
+IndexRange* mergeSorted(const IndexRange* first1,
+                        const IndexRange* last1,
+                        const IndexRange* first2,
+                        const IndexRange* last2,
+                        IndexRange* output,
+                        std::size_t& cardinality)
+{
+    cardinality = 0;
+
+    if (first1 == last1 && first2 == last2)
+        return output;
+
+    auto next = [&]() {
+        if (first2 == last2 || (first1 != last1 && first1->location <= first2->location))
+            return *first1++;
+
+        return *first2++;
+    };
+
+    IndexRange current = next();
+
+    while (first1 != last1 || first2 != last2)
+    {
+        IndexRange range = next();
+
+        if (current.getMax() >= range.location)
+        {
+            if (range.getMax() > current.getMax())
+                current.setMax(range.getMax());
+        }
+        else
+        {
+            cardinality += current.size;
+            *output++ = current;
+            current = range;
+        }
+    }
+
+    cardinality += current.size;
+    *output++ = current;
+    return output;
+}
+
+
+/// \brief Sort ranges sequentially.
+void sortSequential(IndexRange* first, IndexRange* last)
+{
+    std::size_t count = last - first;
+
+    if (count < RADIX_SORT_THRESHOLD)
+    {
+        std::sort(first, last);
+        return;
+    }
+
+    const IndexRange* sorted = radixSort(first, last);
+
+    if (sorted != first)
+        std::memcpy(first, sorted, count * sizeof(IndexRange));
+}
+
+
+/// \brief Sort ranges, in parallel for large batches.
+void sortRanges(IndexRange* first, IndexRange* last)
+{
+    std::size_t count = last - first;
+
+    if (!IndexRangeParallel::isParallel(count))
+    {
+        sortSequential(first, last);
+        return;
+    }
+
+    std::size_t numChunks = std::min(count, IndexRangeParallel::numThreads());
+
+    auto boundary = [&](std::size_t chunk) {
+        return first + (count * std::min(chunk, numChunks)) / numChunks;
+    };
+
+    IndexRangeParallel::forEach(numChunks, [&](std::size_t chunk) {
+        sortSequential(boundary(chunk), boundary(chunk + 1));
+    });
+
+    // Merge pairs of neighboring sorted chunks until one remains.
+    for (std::size_t width = 1; width < numChunks; width *= 2)
+    {
+        std::size_t numMerges = (numChunks + 2 * width - 1) / (2 * width);
+
+        IndexRangeParallel::forEach(numMerges, [&](std::size_t i) {
+            std::size_t chunk = i * 2 * width;
+            std::inplace_merge(boundary(chunk),
+                               boundary(chunk + width),
+                               boundary(chunk + 2 * width));
+        });
+    }
+}
+
+
+/// \brief The number of bits in a bitset word.
+const std::size_t WORD_BITS = 64;
+
+
+/// \brief Mix the bits of a value, from the SplitMix64 finalizer.
+uint64_t mixHash(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+
+/// \brief Hash a merged range by its gap from the previous range and size.
+///
+/// Gaps are unchanged when later ranges shift together, which keeps the
+/// fingerprint cheap to update in insert().
+uint64_t hashRange(std::size_t gap, std::size_t size)
+{
+    return mixHash(mixHash(gap) ^ size);
+}
+
+
+/// \brief The number of chunks per thread in forEachParallel(), so that
+///        threads that finish early pick up remaining chunks.
+const std::size_t CHUNKS_PER_THREAD = 4;
+
+
+/// \returns the index of the lowest set bit of a non-zero word.
+inline std::size_t countTrailingZeros(uint64_t word)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, word);
+    return index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+
+} // namespace
+
+
+template <typename OverflowPolicy>
+IndexRangeList_<OverflowPolicy>::IndexRangeList_():
+    _sorted(true),
+    _offsetsValid(false),
+    _hashValid(true)
 {
 }
 
 
-IndexRangeList::IndexRangeList(const std::vector<IndexRange>& ranges)
+template <typename OverflowPolicy>
+IndexRangeList_<OverflowPolicy>::IndexRangeList_(const std::vector<IndexRange>& ranges):
+    IndexRangeList_()
 {
     for (auto& range: ranges)
         add(range);
 }
 
 
-IndexRangeList::~IndexRangeList()
+template <typename OverflowPolicy>
+IndexRangeList_<OverflowPolicy>::IndexRangeList_(const IndexRangeList_& other):
+    _ranges(other._ranges),
+    _sortedSize(other._sortedSize),
+    _cardinality(other._cardinality),
+    _hash(other._hash),
+    _sorted(other._sorted),
+    _offsetsValid(false),
+    _hashValid(other._hashValid)
 {
 }
 
 
-void IndexRangeList::add(const IndexRange& _range)
+template <typename OverflowPolicy>
+IndexRangeList_<OverflowPolicy>::IndexRangeList_(IndexRangeList_&& other) noexcept:
+    _ranges(std::move(other._ranges)),
+    _sortedSize(other._sortedSize),
+    _cardinality(other._cardinality),
+    _hash(other._hash),
+    _offsets(std::move(other._offsets)),
+    _sorted(other._sorted),
+    _offsetsValid(other._offsetsValid),
+    _hashValid(other._hashValid)
 {
-    IndexRange range = validate(_range);
+    other.clear();
+}
 
-    if (range.empty())
-        return;
 
-    _ranges.push_back(range);
-    _sorted = false;
+template <typename OverflowPolicy>
+IndexRangeList_<OverflowPolicy>::~IndexRangeList_()
+{
+}
+
+
+template <typename OverflowPolicy>
+IndexRangeList_<OverflowPolicy>& IndexRangeList_<OverflowPolicy>::operator = (const IndexRangeList_& other)
+{
+    if (this != &other)
+    {
+        _ranges = other._ranges;
+        _sortedSize = other._sortedSize;
+        _cardinality = other._cardinality;
+        _hash = other._hash;
+        _sorted = other._sorted;
+        _offsetsValid = false;
+        _hashValid = other._hashValid;
+    }
+
+    return *this;
+}
+
+
+template <typename OverflowPolicy>
+IndexRangeList_<OverflowPolicy>& IndexRangeList_<OverflowPolicy>::operator = (IndexRangeList_&& other) noexcept
+{
+    if (this != &other)
+    {
+        _ranges = std::move(other._ranges);
+        _sortedSize = other._sortedSize;
+        _cardinality = other._cardinality;
+        _hash = other._hash;
+        _offsets = std::move(other._offsets);
+        _sorted = other._sorted;
+        _offsetsValid = other._offsetsValid;
+        _hashValid = other._hashValid;
+        other.clear();
+    }
+
+    return *this;
 }
 
 
-void IndexRangeList::remove(const IndexRange& _range)
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::add(const IndexRange& _range)
 {
     IndexRange range = validate(_range);
 
     if (range.empty())
         return;
 
-    _sort();
-
-    bool foundIntersection = false;
-    auto iter = _ranges.begin();
-    while (iter != _ranges.end())
+    if (_sorted)
     {
-        IndexRange intersection = range.intersectionWith(*iter);
-
-        if (intersection.size != 0)
+        // Appending in order, the common case for streaming producers.
+        if (_ranges.empty() || range.location >= _ranges.back().location)
         {
-            foundIntersection = true;
+            std::size_t back = _ranges.empty() ? 0 : _ranges.size() - 1;
+
+            if (_hashValid)
+                _hash -= _hashOf(back, _ranges.size());
 
-            if (intersection.getMin() == iter->getMin())
+            if (!_ranges.empty() && _ranges.back().getMax() >= range.location)
             {
-                // Lower overlap.
-                if (intersection.getMax() < iter->getMax())
-                {
-                    iter->setMin(intersection.getMax());
-                    ++iter;
-                }
-                else
+                IndexRange& back = _ranges.back();
+
+                if (range.getMax() > back.getMax())
                 {
-                    // Full overlap.
-                    iter = _ranges.erase(iter);
+                    _cardinality += range.getMax() - back.getMax();
+                    back.setMax(range.getMax());
                 }
             }
-            else if (intersection.getMax() == iter->getMax())
-            {
-                iter->setMax(intersection.getMin());
-                ++iter;
-            }
             else
             {
-                IndexRange hi = *iter;
-                hi.setMin(intersection.getMax());
-                iter->setMax(intersection.getMin());
-                iter = _ranges.insert(iter, hi);
+                if (_offsetsValid)
+                    _offsets->push_back(_cardinality);
+
+                _ranges.push_back(range);
+                _cardinality += range.size;
             }
+
+            if (_hashValid)
+                _hash += _hashOf(back, _ranges.size());
+
+            _sortedSize = _ranges.size();
+            return;
         }
-        else if (foundIntersection)
-        {
-            // We previously found an intersection and now didn't find one,
-            // which means we're past since we sorted.
-            break;
-        }
-        else
+
+        // Slightly out of order, merge in place near the tail.
+        std::size_t distance = std::min(_ranges.size(), NEAR_TAIL_DISTANCE);
+        IndexRange* first = _ranges.end() - distance;
+
+        if (range.location >= first->location)
         {
-            ++iter;
+            // The ranges that overlap or are adjacent to the new range.
+            IndexRange* lo = std::lower_bound(first, _ranges.end(), range.location, [](const IndexRange& r, std::size_t location) {
+                return r.getMax() < location;
+            });
+
+            IndexRange* hi = lo;
+            IndexRange merged = range;
+
+            while (hi != _ranges.end() && hi->location <= range.getMax())
+            {
+                _cardinality -= hi->size;
+                merged = merged.unionWith(*hi);
+                ++hi;
+            }
+
+            _cardinality += merged.size;
+
+            std::size_t i = lo - _ranges.begin();
+
+            if (_hashValid)
+                _hash -= _hashOf(i, hi - _ranges.begin());
+
+            if (lo == hi)
+            {
+                _ranges.insert(lo, merged);
+            }
+            else
+            {
+                *lo = merged;
+                _ranges.erase(lo + 1, hi);
+            }
+
+            if (_hashValid)
+                _hash += _hashOf(i, i + 1);
+
+            _sortedSize = _ranges.size();
+            _offsetsValid = false;
+            return;
         }
     }
 
-    // TODO: we are still sorted?
+    // The sorted prefix grows as long as ranges arrive in order.
+    if (_sortedSize == _ranges.size()
+    && (_ranges.empty() || range.location >= _ranges.back().location))
+    {
+        ++_sortedSize;
+    }
+
+    _ranges.push_back(range);
     _sorted = false;
+    _offsetsValid = false;
+    _hashValid = false;
+}
+
+
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::add(const IndexRangeList_& other)
+{
+    *this = unionWith(other);
+}
+
+
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::remove(const IndexRange& _range)
+{
+    IndexRange range = validate(_range);
+
+    if (range.empty())
+        return;
+
+    _sort();
+
+    // The ranges that intersect are [first, last).
+    IndexRange* first = std::upper_bound(_ranges.begin(),
+                                         _ranges.end(),
+                                         range.location,
+                                         [](std::size_t location, const IndexRange& r) {
+                                             return location < r.getMax();
+                                         });
+
+    IndexRange* last = std::lower_bound(first,
+                                        _ranges.end(),
+                                        range.getMax(),
+                                        [](const IndexRange& r, std::size_t max) {
+                                            return r.location < max;
+                                        });
+
+    if (first == last)
+        return;
+
+    std::size_t i = first - _ranges.begin();
+    std::size_t count = last - first;
+    std::size_t size = _ranges.size();
+
+    if (_hashValid)
+        _hash -= _hashOf(i, i + count);
+
+    _offsetsValid = false;
+
+    if (first + 1 == last
+     && first->location < range.location
+     && first->getMax() > range.getMax())
+    {
+        // Split a single range, keeping the upper part after it.
+        IndexRange hi = IndexRange::fromExclusiveInterval(range.getMax(), first->getMax());
+        first->setMax(range.location);
+        _cardinality -= range.size;
+        _ranges.insert(first + 1, hi);
+        _sortedSize = _ranges.size();
+
+        if (_hashValid)
+            _hash += _hashOf(i, i + 2);
+
+        return;
+    }
+
+    if (first->location < range.location)
+    {
+        _cardinality -= first->getMax() - range.location;
+        first->setMax(range.location);
+        ++first;
+    }
+
+    if (first != last && (last - 1)->getMax() > range.getMax())
+    {
+        --last;
+        _cardinality -= range.getMax() - last->location;
+        last->setMin(range.getMax());
+    }
+
+    for (IndexRange* iter = first; iter != last; ++iter)
+        _cardinality -= iter->size;
+
+    // Removing keeps the ranges sorted and apart.
+    _ranges.erase(first, last);
+    _sortedSize = _ranges.size();
+
+    if (_hashValid)
+        _hash += _hashOf(i, i + count - (size - _ranges.size()));
+}
+
+
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::remove(const IndexRangeList_& other)
+{
+    *this = differenceWith(other);
 }
 
 
-void IndexRangeList::insert(const IndexRange& _range)
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::insert(const IndexRange& _range)
 {
     IndexRange range = validate(_range);
 
@@ -113,6 +610,51 @@ void IndexRangeList::insert(const IndexRange& _range)
 
     _sort();
 
+    // Ranges ending at or before the insert location do not move.
+    IndexRange* first = std::upper_bound(_ranges.begin(),
+                                         _ranges.end(),
+                                         range.location,
+                                         [](std::size_t location, const IndexRange& r) {
+                                             return location < r.getMax();
+                                         });
+
+    if (first == _ranges.end())
+        return;
+
+    if (!OverflowPolicy::CHECK || _ranges.back().getMax() <= IndexRange::MAX - range.size)
+    {
+        // Later ranges shift together, so only the gap or size of the first
+        // range changes.
+        std::size_t i = first - _ranges.begin();
+
+        if (_hashValid)
+            _hash -= _hashOf(i, i + 1);
+
+        // Nothing can overflow, so shifting is a plain loop.
+        if (first->location <= range.location)
+        {
+            first->size += range.size;
+            _cardinality += range.size;
+            ++first;
+        }
+
+        for (IndexRange* iter = first; iter != _ranges.end(); ++iter)
+            iter->location += range.size;
+
+        if (_hashValid)
+            _hash += _hashOf(i, i + 1);
+
+        // Shifting keeps the ranges sorted and apart.
+        _offsetsValid = false;
+        return;
+    }
+
+    // Ranges are shifted past the end, so they are clamped one at a time.
+    // The last range is always one of them.
+    OverflowPolicy::overflow(_ranges.back());
+
+    _cardinality = 0;
+
     auto iter = _ranges.begin();
 
     while (iter != _ranges.end())
@@ -137,17 +679,27 @@ void IndexRangeList::insert(const IndexRange& _range)
         // TODO: Preserve overflow?
         curr.clearOverflow();
 
-        if (overflow)
+        if (overflow || curr.empty())
+        {
             iter = _ranges.erase(iter);
+        }
         else
+        {
+            _cardinality += curr.size;
             ++iter;
+        }
     }
 
+    // Shifting keeps the order, but truncated ranges may need merging.
     _sorted = false;
+    _sortedSize = _ranges.size();
+    _offsetsValid = false;
+    _hashValid = false;
 }
 
 
-void IndexRangeList::erase(const IndexRange& _range)
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::erase(const IndexRange& _range)
 {
     IndexRange range = validate(_range);
 
@@ -158,9 +710,13 @@ void IndexRangeList::erase(const IndexRange& _range)
 
     // No need to sort because all need to be checked, unless we are starting from the high side?
 
-    auto iter = _ranges.begin();
+    _cardinality = 0;
 
-    while (iter != _ranges.end())
+    // Ranges are compacted in place, which keeps their relative order.
+    std::size_t sortedSize = 0;
+    auto last = _ranges.begin();
+
+    for (auto iter = _ranges.begin(); iter != _ranges.end(); ++iter)
     {
         // Something will happen.
         if (range.getMin() < iter->getMax())
@@ -182,83 +738,910 @@ void IndexRangeList::erase(const IndexRange& _range)
             // Nothing will change.
         }
 
-        if (0 == iter->size)
-            iter = _ranges.erase(iter);
-        else
-            ++iter;
+        if (0 != iter->size)
+        {
+            if (std::size_t(iter - _ranges.begin()) < _sortedSize)
+                ++sortedSize;
+
+            _cardinality += iter->size;
+            *last++ = *iter;
+        }
     }
-}
 
+    _ranges.erase(last, _ranges.end());
 
-void IndexRangeList::clear()
-{
-    _ranges.clear();
-    _sorted = true;
+    // Erasing keeps the order of the sorted prefix, but ranges on either
+    // side of the erased section may now be adjacent and need merging.
+    _sortedSize = sortedSize;
+    _sorted = false;
+    _offsetsValid = false;
+    _hashValid = false;
 }
 
 
-std::size_t IndexRangeList::size() const
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::apply(const std::vector<IndexRangeEdit>& edits)
 {
-    _sort();
+    // Normalize the batch into sorted inserts and sorted, merged erases.
+    std::vector<IndexRange> inserts;
+    IndexRangeList_ erases;
+
+    for (auto& edit: edits)
+    {
+        IndexRange range = validate(edit.range);
+
+        if (range.empty())
+            continue;
+
+        if (edit.type == IndexRangeEdit::Type::INSERT)
+            inserts.push_back(range);
+        else
+            erases.add(range);
+    }
+
+    if (inserts.empty() && erases.empty())
+        return;
+
+    std::sort(inserts.begin(), inserts.end());
+
+    erases._sort();
+    _sort();
+
+    // The running offset is tracked separately for inserts and erases, and
+    // both only move forward since the mapped indices are increasing.
+    auto insert = inserts.begin();
+    auto erase = erases._ranges.begin();
+    std::size_t inserted = 0;
+    std::size_t erased = 0;
+
+    // Map an index, returning false if it overflows.
+    auto map = [&](std::size_t index, std::size_t& result) {
+        for (; insert != inserts.end() && insert->location < index; ++insert)
+            inserted += insert->size;
+
+        for (; erase != erases._ranges.end() && erase->getMax() <= index; ++erase)
+            erased += erase->size;
+
+        std::size_t partial = 0;
+
+        if (erase != erases._ranges.end() && erase->location < index)
+            partial = index - erase->location;
+
+        std::size_t base = index - erased - partial;
+        result = base + inserted;
+        return result >= base;
+    };
+
+    IndexRangeVector ranges;
+    ranges.reserve(_ranges.size());
+
+    for (auto& range: _ranges)
+    {
+        std::size_t min = 0;
+        std::size_t max = 0;
+
+        bool minOverflows = !map(range.getMin(), min);
+        bool maxOverflows = !map(range.getMax(), max);
+
+        if (OverflowPolicy::CHECK && maxOverflows)
+            OverflowPolicy::overflow(range);
+
+        // Ranges starting past the end are removed, like insert().
+        if (minOverflows)
+            break;
+
+        if (maxOverflows)
+            max = IndexRange::MAX;
+
+        appendMerged(ranges, IndexRange::fromExclusiveInterval(min, max));
+    }
+
+    _assignSorted(std::move(ranges));
+}
+
+
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::apply(const IndexRangeMapper& mapper)
+{
+    if (mapper.isIdentity())
+        return;
+
+    _sort();
+
+    // The boundaries are sorted, so they are mapped with a linear walk.
+    std::vector<std::size_t> indices;
+    indices.reserve(_ranges.size() * 2);
+
+    for (auto& range: _ranges)
+    {
+        indices.push_back(range.getMin());
+        indices.push_back(range.getMax());
+    }
+
+    mapper.map(indices.data(), indices.data(), indices.size());
+
+    IndexRangeVector ranges;
+    ranges.reserve(_ranges.size());
+
+    for (std::size_t i = 0; i < indices.size(); i += 2)
+    {
+        // Lost indices are mapped to IndexRange::MAX, but so is an index
+        // moved exactly to MAX, so ask the mapper.
+        if (OverflowPolicy::CHECK && mapper.isLost(_ranges[i / 2].getMax()))
+            OverflowPolicy::overflow(_ranges[i / 2]);
+
+        // Ranges starting past the end are removed, like insert().
+        if (indices[i] == IndexRange::MAX)
+            break;
+
+        appendMerged(ranges, IndexRange::fromExclusiveInterval(indices[i], indices[i + 1]));
+    }
+
+    _assignSorted(std::move(ranges));
+}
+
+
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::clear()
+{
+    _ranges.clear();
+    _sorted = true;
+    _sortedSize = 0;
+    _cardinality = 0;
+    _offsetsValid = false;
+    _hash = 0;
+    _hashValid = true;
+}
+
+
+template <typename OverflowPolicy>
+std::size_t IndexRangeList_<OverflowPolicy>::size() const
+{
+    _sort();
     return _ranges.size();
 }
 
 
-bool IndexRangeList::empty() const
+template <typename OverflowPolicy>
+bool IndexRangeList_<OverflowPolicy>::empty() const
 {
     _sort();
     return _ranges.empty();
 }
 
 
-void IndexRangeList::_sort() const
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::_sort() const
 {
     if (!_sorted)
     {
-        // Nothing to sort otherwise, and iterator math will fail.
-        if (_ranges.size() > 1)
+        IndexRange* begin = _ranges.begin();
+        IndexRange* end = _ranges.end();
+        IndexRange* middle = begin + _sortedSize;
+        IndexRange* last = end;
+
+        std::size_t tailSize = end - middle;
+
+        if (tailSize >= RADIX_SORT_THRESHOLD
+        && !IndexRangeParallel::isParallel(tailSize))
+        {
+            // Radix sort the tail and merge it with the sorted prefix while
+            // writing the output, so the sorted tail is never copied back. The
+            // prefix is moved out of the way, and the output never passes the
+            // next unread range of the tail.
+            std::vector<IndexRange> prefix(begin, middle);
+            const IndexRange* tail = radixSort(middle, end);
+            last = mergeSorted(prefix.data(), prefix.data() + prefix.size(),
+                               tail, tail + tailSize,
+                               begin,
+                               _cardinality);
+        }
+        else
+        {
+            if (middle != end)
+            {
+                // Sort the unsorted tail, then merge it into the sorted prefix.
+                sortRanges(middle, end);
+                std::inplace_merge(begin, middle, end);
+            }
+
+            // Merge overlapping and adjacent ranges in a single pass.
+            last = mergeSorted(begin, end, begin, _cardinality);
+        }
+
+        _ranges.erase(last, end);
+
+        _sorted = true;
+        _sortedSize = _ranges.size();
+    }
+}
+
+
+template <typename OverflowPolicy>
+uint64_t IndexRangeList_<OverflowPolicy>::_hashOf(std::size_t first, std::size_t last) const
+{
+    uint64_t result = 0;
+
+    last = std::min(last + 1, _ranges.size());
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+        std::size_t previous = i > 0 ? _ranges[i - 1].getMax() : 0;
+        result += hashRange(_ranges[i].location - previous, _ranges[i].size);
+    }
+
+    return result;
+}
+
+
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::_assignSorted(IndexRangeVector&& ranges)
+{
+    _ranges = std::move(ranges);
+    _cardinality = 0;
+
+    for (auto& range: _ranges)
+        _cardinality += range.size;
+
+    _sorted = true;
+    _sortedSize = _ranges.size();
+    _offsetsValid = false;
+    _hashValid = false;
+}
+
+
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::_updateOffsets() const
+{
+    _sort();
+
+    if (!_offsetsValid)
+    {
+        if (!_offsets)
+            _offsets.reset(new std::vector<std::size_t>());
+
+        std::vector<std::size_t>& offsets = *_offsets;
+        offsets.resize(_ranges.size());
+
+        std::size_t offset = 0;
+
+        for (std::size_t i = 0; i < _ranges.size(); ++i)
+        {
+            offsets[i] = offset;
+            offset += _ranges[i].size;
+        }
+
+        _offsetsValid = true;
+    }
+}
+
+
+template <typename OverflowPolicy>
+std::vector<IndexRange> IndexRangeList_<OverflowPolicy>::ranges() const
+{
+    _sort();
+    return std::vector<IndexRange>(_ranges.begin(), _ranges.end());
+}
+
+
+template <typename OverflowPolicy>
+typename IndexRangeList_<OverflowPolicy>::const_iterator IndexRangeList_<OverflowPolicy>::begin() const
+{
+    _sort();
+    return _ranges.begin();
+}
+
+
+template <typename OverflowPolicy>
+typename IndexRangeList_<OverflowPolicy>::const_iterator IndexRangeList_<OverflowPolicy>::end() const
+{
+    _sort();
+    return _ranges.end();
+}
+
+
+template <typename OverflowPolicy>
+const IndexRange& IndexRangeList_<OverflowPolicy>::front() const
+{
+    _sort();
+    return _ranges.front();
+}
+
+
+template <typename OverflowPolicy>
+const IndexRange& IndexRangeList_<OverflowPolicy>::back() const
+{
+    _sort();
+    return _ranges.back();
+}
+
+
+template <typename OverflowPolicy>
+bool IndexRangeList_<OverflowPolicy>::contains(std::size_t index) const
+{
+    _sort();
+
+    auto iter = std::upper_bound(_ranges.begin(),
+                                 _ranges.end(),
+                                 index,
+                                 [](std::size_t i, const IndexRange& range) {
+                                     return i < range.getMax();
+                                 });
+
+    return iter != _ranges.end() && iter->contains(index);
+}
+
+
+template <typename OverflowPolicy>
+std::size_t IndexRangeList_<OverflowPolicy>::cardinality() const
+{
+    _sort();
+    return _cardinality;
+}
+
+
+template <typename OverflowPolicy>
+std::size_t IndexRangeList_<OverflowPolicy>::rank(std::size_t index) const
+{
+    _sort();
+
+    // Small lists are cheaper to scan than to index.
+    if (_ranges.size() <= IndexRangeVector::INLINE_CAPACITY)
+    {
+        std::size_t result = 0;
+
+        for (auto& range: _ranges)
+        {
+            if (range.location >= index)
+                break;
+
+            result += std::min(range.size, index - range.location);
+        }
+
+        return result;
+    }
+
+    _updateOffsets();
+
+    // Find the first range starting after the index.
+    auto iter = std::upper_bound(_ranges.begin(),
+                                 _ranges.end(),
+                                 index,
+                                 [](std::size_t i, const IndexRange& range) {
+                                     return i < range.location;
+                                 });
+
+    if (iter == _ranges.begin())
+        return 0;
+
+    --iter;
+
+    std::size_t i = iter - _ranges.begin();
+    return (*_offsets)[i] + std::min(iter->size, index - iter->location);
+}
+
+
+template <typename OverflowPolicy>
+std::size_t IndexRangeList_<OverflowPolicy>::select(std::size_t k) const
+{
+    _sort();
+
+    if (k >= _cardinality)
+        return IndexRange::MAX;
+
+    if (_ranges.size() <= IndexRangeVector::INLINE_CAPACITY)
+    {
+        for (auto& range: _ranges)
+        {
+            if (k < range.size)
+                return range.location + k;
+
+            k -= range.size;
+        }
+
+        return IndexRange::MAX;
+    }
+
+    _updateOffsets();
+
+    const std::vector<std::size_t>& offsets = *_offsets;
+
+    // Find the last range with an offset <= k.
+    auto iter = std::upper_bound(offsets.begin(), offsets.end(), k);
+    std::size_t i = (iter - offsets.begin()) - 1;
+    return _ranges[i].location + (k - offsets[i]);
+}
+
+
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::forEachParallel(const std::function<void(const IndexRange&, std::size_t)>& function,
+                                                      std::size_t grainSize) const
+{
+    _sort();
+
+    std::size_t numThreads = IndexRangeParallel::numThreads();
+
+    if (numThreads <= 1 || _cardinality <= grainSize)
+    {
+        std::size_t offset = 0;
+
+        for (auto& range: _ranges)
         {
-            std::sort(_ranges.begin(), _ranges.end());
+            function(range, offset);
+            offset += range.size;
+        }
+
+        return;
+    }
+
+    // Update the offsets before any thread reads them.
+    _updateOffsets();
+
+    const std::vector<std::size_t>& offsets = *_offsets;
+    std::size_t numChunks = numThreads * CHUNKS_PER_THREAD;
+    std::size_t chunkSize = std::max(std::max(grainSize, std::size_t(1)),
+                                     (_cardinality + numChunks - 1) / numChunks);
+    numChunks = (_cardinality + chunkSize - 1) / chunkSize;
+
+    IndexRangeParallel::forEach(numChunks, [&](std::size_t chunk) {
+        std::size_t first = chunk * chunkSize;
+        std::size_t last = std::min(first + chunkSize, _cardinality);
+
+        // Find the last range with an offset <= first.
+        auto iter = std::upper_bound(offsets.begin(), offsets.end(), first);
+        std::size_t i = (iter - offsets.begin()) - 1;
+
+        for (std::size_t k = first; k < last; ++i)
+        {
+            std::size_t begin = k - offsets[i];
+            std::size_t end = std::min(_ranges[i].size, last - offsets[i]);
+            function(IndexRange(_ranges[i].location + begin, end - begin), k);
+            k += end - begin;
+        }
+    });
+}
+
+
+template <typename OverflowPolicy>
+IndexRangeList_<OverflowPolicy> IndexRangeList_<OverflowPolicy>::unionWith(const IndexRangeList_& other) const
+{
+    return _combine(*this, other, Operation::UNION);
+}
+
+
+template <typename OverflowPolicy>
+IndexRangeList_<OverflowPolicy> IndexRangeList_<OverflowPolicy>::intersectionWith(const IndexRangeList_& other) const
+{
+    return _combine(*this, other, Operation::INTERSECTION);
+}
 
-            auto iter = _ranges.begin() + 1;
 
-            while (iter != _ranges.end())
+template <typename OverflowPolicy>
+IndexRangeList_<OverflowPolicy> IndexRangeList_<OverflowPolicy>::differenceWith(const IndexRangeList_& other) const
+{
+    return _combine(*this, other, Operation::DIFFERENCE);
+}
+
+
+template <typename OverflowPolicy>
+bool IndexRangeList_<OverflowPolicy>::operator == (const IndexRangeList_& other) const
+{
+    // Lists with different fingerprints cannot be equal.
+    if (_hashValid && other._hashValid && _hash != other._hash)
+        return false;
+
+    _sort();
+    other._sort();
+
+    return _cardinality == other._cardinality
+        && _ranges.size() == other._ranges.size()
+        && std::equal(_ranges.begin(), _ranges.end(), other._ranges.begin());
+}
+
+
+template <typename OverflowPolicy>
+uint64_t IndexRangeList_<OverflowPolicy>::hash() const
+{
+    _sort();
+
+    if (!_hashValid)
+    {
+        _hash = _hashOf(0, _ranges.size());
+        _hashValid = true;
+    }
+
+    return _hash;
+}
+
+
+template <typename OverflowPolicy>
+bool IndexRangeList_<OverflowPolicy>::operator != (const IndexRangeList_& other) const
+{
+    return !(*this == other);
+}
+
+
+template <typename OverflowPolicy>
+std::vector<IndexRangeRequest> IndexRangeList_<OverflowPolicy>::coalesce(const IndexRangeCoalesceSettings& settings) const
+{
+    _sort();
+
+    std::size_t alignment = std::max(std::size_t(1), settings.alignment);
+
+    // The largest request, as a multiple of the alignment.
+    std::size_t maxSize = settings.maxSize - (settings.maxSize % alignment);
+    maxSize = std::max(alignment, maxSize);
+
+    auto alignDown = [&](std::size_t x) {
+        return x - (x % alignment);
+    };
+
+    auto alignUp = [&](std::size_t x) {
+        std::size_t remainder = x % alignment;
+
+        if (remainder == 0)
+            return x;
+
+        std::size_t result = x + (alignment - remainder);
+        return result < x ? IndexRange::MAX : result;
+    };
+
+    auto limitOf = [&](std::size_t location) {
+        std::size_t limit = location + maxSize;
+        return limit < location ? IndexRange::MAX : limit;
+    };
+
+    std::vector<IndexRangeRequest> results;
+
+    for (auto& range: _ranges)
+    {
+        std::size_t location = range.location;
+        std::size_t max = range.getMax();
+
+        while (location < max)
+        {
+            if (!results.empty())
             {
-                auto& last = *(iter - 1); // Last range.
-                auto& curr = *(iter);     // Current range.
+                IndexRangeRequest& current = results.back();
+                std::size_t currentMax = current.range.getMax();
+                std::size_t alignedLocation = alignDown(location);
+                std::size_t gap = alignedLocation > currentMax ? alignedLocation - currentMax : 0;
+                std::size_t limit = limitOf(current.range.location);
 
-                IndexRange merged = last.mergeWith(curr);
+                if (gap <= settings.maxGap && location < limit)
+                {
+                    std::size_t pieceMax = std::min(max, limit);
+                    current.range.setMax(std::min(limit, std::max(currentMax, alignUp(pieceMax))));
+                    current.ranges.push_back(IndexRange::fromExclusiveInterval(location, pieceMax));
+                    location = pieceMax;
+                    continue;
+                }
+            }
+
+            // Start a new request.
+            IndexRangeRequest request;
+            request.range.location = alignDown(location);
+            std::size_t limit = limitOf(request.range.location);
+            std::size_t pieceMax = std::min(max, limit);
+            request.range.setMax(std::min(limit, alignUp(pieceMax)));
+            request.ranges.push_back(IndexRange::fromExclusiveInterval(location, pieceMax));
+            results.push_back(std::move(request));
+            location = pieceMax;
+        }
+    }
+
+    return results;
+}
 
-                if (merged.size != 0)
+
+template <typename OverflowPolicy>
+void IndexRangeList_<OverflowPolicy>::toBitset(uint64_t* words, std::size_t numBits) const
+{
+    std::size_t numWords = (numBits + WORD_BITS - 1) / WORD_BITS;
+
+    if (numWords == 0)
+        return;
+
+    std::memset(words, 0, numWords * sizeof(uint64_t));
+
+    _sort();
+
+    for (auto& range: _ranges)
+    {
+        if (range.location >= numBits)
+            break;
+
+        std::size_t first = range.location;
+        std::size_t last = std::min(range.getMax(), numBits);
+
+        std::size_t firstWord = first / WORD_BITS;
+        std::size_t lastWord = last / WORD_BITS;
+        uint64_t firstMask = ~uint64_t(0) << (first % WORD_BITS);
+        uint64_t lastMask = (uint64_t(1) << (last % WORD_BITS)) - 1;
+
+        if (firstWord == lastWord)
+        {
+            words[firstWord] |= firstMask & lastMask;
+        }
+        else
+        {
+            words[firstWord] |= firstMask;
+
+            if (lastWord > firstWord + 1)
+                std::memset(words + firstWord + 1, 0xFF, (lastWord - firstWord - 1) * sizeof(uint64_t));
+
+            // lastWord may be one past the end when last is a multiple of 64.
+            if (lastMask != 0)
+                words[lastWord] |= lastMask;
+        }
+    }
+}
+
+
+template <typename OverflowPolicy>
+std::vector<uint64_t> IndexRangeList_<OverflowPolicy>::toBitset(std::size_t numBits) const
+{
+    std::vector<uint64_t> words((numBits + WORD_BITS - 1) / WORD_BITS);
+    toBitset(words.data(), numBits);
+    return words;
+}
+
+
+template <typename OverflowPolicy>
+IndexRangeList_<OverflowPolicy> IndexRangeList_<OverflowPolicy>::fromBitset(const uint64_t* words, std::size_t numBits)
+{
+    IndexRangeVector ranges;
+
+    std::size_t numWords = (numBits + WORD_BITS - 1) / WORD_BITS;
+    std::size_t start = 0;
+    uint64_t carry = 0;
+    bool inRun = false;
+
+    for (std::size_t i = 0; i < numWords; ++i)
+    {
+        uint64_t word = words[i];
+
+        if (i + 1 == numWords && numBits % WORD_BITS != 0)
+            word &= (uint64_t(1) << (numBits % WORD_BITS)) - 1;
+
+        // Each set bit marks a bit that differs from the bit below it, i.e.
+        // the start or end of a run. Uniform words have no transitions.
+        uint64_t transitions = word ^ ((word << 1) | carry);
+        carry = word >> (WORD_BITS - 1);
+
+        while (transitions != 0)
+        {
+            std::size_t index = i * WORD_BITS + countTrailingZeros(transitions);
+
+            if (inRun)
+                ranges.push_back(IndexRange::fromExclusiveInterval(start, index));
+            else
+                start = index;
+
+            inRun = !inRun;
+            transitions &= transitions - 1;
+        }
+    }
+
+    if (inRun)
+        ranges.push_back(IndexRange::fromExclusiveInterval(start, numBits));
+
+    IndexRangeList_ result;
+    result._assignSorted(std::move(ranges));
+    return result;
+}
+
+
+template <typename OverflowPolicy>
+IndexRangeList_<OverflowPolicy> IndexRangeList_<OverflowPolicy>::fromBitset(const std::vector<uint64_t>& words)
+{
+    return fromBitset(words.data(), words.size() * WORD_BITS);
+}
+
+
+template <typename OverflowPolicy>
+bool IndexRangeList_<OverflowPolicy>::isSmallerAsBitset(std::size_t numBits) const
+{
+    std::size_t bitsetBytes = (numBits + WORD_BITS - 1) / WORD_BITS * sizeof(uint64_t);
+    return bitsetBytes < size() * sizeof(IndexRange);
+}
+
+
+template <typename OverflowPolicy>
+IndexRangeList_<OverflowPolicy> IndexRangeList_<OverflowPolicy>::_combine(const IndexRangeList_& a,
+                                                                          const IndexRangeList_& b,
+                                                                          Operation operation)
+{
+    a._sort();
+    b._sort();
+
+    typedef const IndexRange* Iterator;
+
+    // Combine the parts of [aFirst, aLast) and [bFirst, bLast) inside window.
+    auto combine = [operation](Iterator aFirst,
+                               Iterator aLast,
+                               Iterator bFirst,
+                               Iterator bLast,
+                               const IndexRange& window,
+                               IndexRangeVector& results)
+    {
+        auto clip = [&](Iterator iter) {
+            return iter->intersectionWith(window);
+        };
+
+        switch (operation)
+        {
+            case Operation::UNION:
+                while (aFirst != aLast || bFirst != bLast)
                 {
-                    last = merged;
-                    iter = _ranges.erase(iter);
+                    if (bFirst == bLast || (aFirst != aLast && aFirst->location < bFirst->location))
+                        appendMerged(results, clip(aFirst++));
+                    else
+                        appendMerged(results, clip(bFirst++));
                 }
-                else
+                break;
+
+            case Operation::INTERSECTION:
+                while (aFirst != aLast && bFirst != bLast)
+                {
+                    appendMerged(results, clip(aFirst).intersectionWith(clip(bFirst)));
+
+                    if (aFirst->getMax() < bFirst->getMax())
+                        ++aFirst;
+                    else
+                        ++bFirst;
+                }
+                break;
+
+            case Operation::DIFFERENCE:
+                for (; aFirst != aLast; ++aFirst)
                 {
-                    ++iter;
+                    IndexRange current = clip(aFirst);
+
+                    while (bFirst != bLast && bFirst->getMax() <= current.location)
+                        ++bFirst;
+
+                    for (Iterator iter = bFirst; iter != bLast && iter->location < current.getMax(); ++iter)
+                    {
+                        if (iter->location > current.location)
+                            appendMerged(results, IndexRange::fromExclusiveInterval(current.location, iter->location));
+
+                        current.setMin(std::min(iter->getMax(), current.getMax()));
+                    }
+
+                    appendMerged(results, current);
                 }
+                break;
+        }
+    };
+
+    Iterator aBegin = a._ranges.begin();
+    Iterator aEnd = a._ranges.end();
+    Iterator bBegin = b._ranges.begin();
+    Iterator bEnd = b._ranges.end();
+
+    std::size_t aSize = aEnd - aBegin;
+    std::size_t bSize = bEnd - bBegin;
+
+    IndexRangeList_ result;
+
+    if (!IndexRangeParallel::isParallel(aSize + bSize))
+    {
+        // Small results stay in the inline storage and do not allocate.
+        combine(aBegin, aEnd, bBegin, bEnd, IndexRange::MAXIMUM_RANGE, result._ranges);
+    }
+    else
+    {
+        // Split the index space so each chunk holds about the same number of
+        // ranges from both inputs. The split locations are found by binary
+        // searching for the k-th range of the merged inputs.
+        std::size_t numChunks = IndexRangeParallel::numThreads();
+        std::vector<std::size_t> cuts(1, 0);
+
+        for (std::size_t chunk = 1; chunk < numChunks; ++chunk)
+        {
+            std::size_t k = ((aSize + bSize) * chunk) / numChunks;
+            std::size_t lo = k > bSize ? k - bSize : 0;
+            std::size_t hi = std::min(k, aSize);
+
+            // Find i such that a[0, i) and b[0, k - i) are the first k ranges.
+            while (lo < hi)
+            {
+                std::size_t i = lo + (hi - lo) / 2;
+
+                if (aBegin[i].location < bBegin[k - i - 1].location)
+                    lo = i + 1;
+                else
+                    hi = i;
             }
+
+            std::size_t cut = IndexRange::MAX;
+
+            if (lo < aSize)
+                cut = aBegin[lo].location;
+
+            if (k - lo < bSize)
+                cut = std::min(cut, bBegin[k - lo].location);
+
+            if (cut > cuts.back())
+                cuts.push_back(cut);
         }
 
-        _sorted = true;
+        cuts.push_back(IndexRange::MAX);
+
+        std::vector<IndexRangeVector> chunks(cuts.size() - 1);
+
+        IndexRangeParallel::forEach(chunks.size(), [&](std::size_t chunk) {
+            IndexRange window = IndexRange::fromExclusiveInterval(cuts[chunk], cuts[chunk + 1]);
+
+            // The ranges ending after the window starts and beginning before
+            // it ends.
+            auto first = [&](Iterator begin, Iterator end) {
+                return std::upper_bound(begin, end, window.location, [](std::size_t location, const IndexRange& range) {
+                    return location < range.getMax();
+                });
+            };
+
+            auto last = [&](Iterator begin, Iterator end) {
+                return std::lower_bound(begin, end, window.getMax(), [](const IndexRange& range, std::size_t location) {
+                    return range.location < location;
+                });
+            };
+
+            combine(first(aBegin, aEnd), last(aBegin, aEnd),
+                    first(bBegin, bEnd), last(bBegin, bEnd),
+                    window,
+                    chunks[chunk]);
+        });
+
+        // Stitch the chunks, merging the ranges that meet at each seam.
+        std::size_t total = 0;
+
+        for (auto& chunk: chunks)
+            total += chunk.size();
+
+        result._ranges.reserve(total);
+
+        for (auto& chunk: chunks)
+            for (auto& range: chunk)
+                appendMerged(result._ranges, range);
     }
-}
 
+    for (auto& range: result._ranges)
+        result._cardinality += range.size;
 
-std::vector<IndexRange> IndexRangeList::ranges() const
-{
-    _sort();
-    return _ranges;
+    result._sorted = true;
+    result._sortedSize = result._ranges.size();
+    result._hashValid = false;
+
+    return result;
 }
 
 
-IndexRange IndexRangeList::validate(const IndexRange& range)
+template <typename OverflowPolicy>
+IndexRange IndexRangeList_<OverflowPolicy>::validate(const IndexRange& range)
 {
     IndexRange result = range;
-    result.clearOverflow();
+
+    if (OverflowPolicy::CHECK && result.overflows())
+    {
+        OverflowPolicy::overflow(result);
+        result.clearOverflow();
+    }
+
     return result;
 }
 
 
+// Keep lists small enough to embed and copy cheaply. This bounds the size
+// only. The list is not aligned, so its inline ranges may straddle cache
+// lines.
+static_assert(sizeof(IndexRangeList) <= 128, "IndexRangeList should be at most 128 bytes.");
+
+
+template class IndexRangeList_<IndexRangeClampPolicy>;
+template class IndexRangeList_<IndexRangeCheckedPolicy>;
+template class IndexRangeList_<IndexRangeUncheckedPolicy>;
+
+
 } // namespace ofx
@@ -0,0 +1,210 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/IndexRangeListIndex.h"
+#include <algorithm>
+
+
+namespace ofx {
+
+
+namespace {
+
+
+/// \brief The delta may hold this many ranges regardless of the main size.
+const std::size_t MIN_DELTA_SIZE = 256;
+
+
+/// \brief Sort and remove duplicate IDs.
+void sortUnique(std::vector<std::size_t>& ids)
+{
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+
+} // namespace
+
+
+IndexRangeListIndex::IndexRangeListIndex()
+{
+}
+
+
+void IndexRangeListIndex::set(std::size_t id, const IndexRangeList& list)
+{
+    remove(id);
+
+    if (list.empty())
+        return;
+
+    for (auto& range: list.ranges())
+        _delta.add(range, id);
+
+    _deltaIds.insert(id);
+    _compactIfNeeded();
+}
+
+
+bool IndexRangeListIndex::remove(std::size_t id)
+{
+    bool removed = false;
+
+    if (_mainIds.count(id) > 0 && _tombstones.insert(id).second)
+        removed = true;
+
+    if (_deltaIds.erase(id) > 0)
+    {
+        _delta.remove(id);
+        removed = true;
+    }
+
+    if (removed)
+        _compactIfNeeded();
+
+    return removed;
+}
+
+
+void IndexRangeListIndex::clear()
+{
+    _main.clear();
+    _mainIds.clear();
+    _tombstones.clear();
+    _delta.clear();
+    _deltaIds.clear();
+}
+
+
+bool IndexRangeListIndex::empty() const
+{
+    return size() == 0;
+}
+
+
+std::size_t IndexRangeListIndex::size() const
+{
+    return _mainIds.size() - _tombstones.size() + _deltaIds.size();
+}
+
+
+bool IndexRangeListIndex::contains(std::size_t id) const
+{
+    return _deltaIds.count(id) > 0
+        || (_mainIds.count(id) > 0 && _tombstones.count(id) == 0);
+}
+
+
+std::vector<std::size_t> IndexRangeListIndex::stab(std::size_t index) const
+{
+    std::vector<std::size_t> results;
+
+    if (index == IndexRange::MAX)
+        return results;
+
+    // The ranges of a list are merged, so at most one per list matches.
+    _forEachOverlapping(IndexRange(index, 1), [&](const IndexRangeInterval& interval) {
+        results.push_back(interval.id);
+    });
+
+    std::sort(results.begin(), results.end());
+    return results;
+}
+
+
+std::vector<std::size_t> IndexRangeListIndex::overlapping(const IndexRange& range) const
+{
+    std::vector<std::size_t> results;
+
+    _forEachOverlapping(range, [&](const IndexRangeInterval& interval) {
+        results.push_back(interval.id);
+    });
+
+    sortUnique(results);
+    return results;
+}
+
+
+std::vector<std::size_t> IndexRangeListIndex::covering(const IndexRange& _range) const
+{
+    std::vector<std::size_t> results;
+
+    IndexRange range = IndexRangeList::validate(_range);
+
+    // The ranges of a list are merged, so a single range must cover.
+    _forEachOverlapping(range, [&](const IndexRangeInterval& interval) {
+        if (interval.range.location <= range.location
+         && interval.range.getMax() >= range.getMax())
+        {
+            results.push_back(interval.id);
+        }
+    });
+
+    std::sort(results.begin(), results.end());
+    return results;
+}
+
+
+void IndexRangeListIndex::compact()
+{
+    if (_delta.empty() && _tombstones.empty())
+        return;
+
+    IndexRangeIntervalTree main;
+
+    for (auto& interval: _main.intervals())
+    {
+        if (_tombstones.count(interval.id) == 0)
+            main.add(interval.range, interval.id);
+    }
+
+    for (auto& interval: _delta.intervals())
+        main.add(interval.range, interval.id);
+
+    for (auto id: _tombstones)
+        _mainIds.erase(id);
+
+    _mainIds.insert(_deltaIds.begin(), _deltaIds.end());
+
+    _main = std::move(main);
+    _tombstones.clear();
+    _delta.clear();
+    _deltaIds.clear();
+}
+
+
+void IndexRangeListIndex::_forEachOverlapping(const IndexRange& range,
+                                              const std::function<void(const IndexRangeInterval&)>& function) const
+{
+    if (_tombstones.empty())
+    {
+        _main.forEachOverlapping(range, function);
+    }
+    else
+    {
+        _main.forEachOverlapping(range, [&](const IndexRangeInterval& interval) {
+            if (_tombstones.count(interval.id) == 0)
+                function(interval);
+        });
+    }
+
+    _delta.forEachOverlapping(range, function);
+}
+
+
+void IndexRangeListIndex::_compactIfNeeded()
+{
+    // Keep the delta and the dead part of the main tree small relative to
+    // the main tree, so that queries stay close to a single tree lookup.
+    std::size_t limit = std::max(MIN_DELTA_SIZE, _main.size() / 8);
+
+    if (_delta.size() > limit || _tombstones.size() > std::max(MIN_DELTA_SIZE, _mainIds.size() / 4))
+        compact();
+}
+
+
+} // namespace ofx
@@ -0,0 +1,499 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/IndexRangeMapper.h"
+#include <algorithm>
+#include "ofx/IndexRangeList.h"
+
+
+namespace ofx {
+
+
+const std::size_t IndexRangeMapper::NONE;
+
+
+namespace {
+
+
+/// \returns a well mixed priority for the node at an index.
+uint64_t mixPriority(uint64_t index)
+{
+    // The splitmix64 finalizer.
+    index += 0x9e3779b97f4a7c15;
+    index = (index ^ (index >> 30)) * 0xbf58476d1ce4e5b9;
+    index = (index ^ (index >> 27)) * 0x94d049bb133111eb;
+    return index ^ (index >> 31);
+}
+
+
+} // namespace
+
+
+IndexRangeMapper::IndexRangeMapper()
+{
+    clear();
+}
+
+
+IndexRangeMapper::IndexRangeMapper(const std::vector<IndexRangeEdit>& edits):
+    IndexRangeMapper()
+{
+    for (auto& edit: edits)
+        apply(edit);
+}
+
+
+void IndexRangeMapper::insert(const IndexRange& _range)
+{
+    IndexRange range = IndexRangeList::validate(_range);
+
+    if (range.empty() || range.location == IndexRange::MAX)
+        return;
+
+    // Indices with targets from here on would move past MAX.
+    std::size_t lost = IndexRange::MAX - range.size + 1;
+
+    _edit();
+    _split(range.location + 1);
+
+    if (lost > range.location + 1)
+        _split(lost);
+
+    std::size_t left = NONE;
+    std::size_t shifted = NONE;
+    std::size_t right = NONE;
+
+    _splitTree(_root, range.location + 1, left, right);
+    _splitTree(right, lost, shifted, right);
+
+    _apply(shifted, false, range.size);
+    _apply(right, true, 0);
+
+    _root = _merge(_merge(left, shifted), right);
+}
+
+
+void IndexRangeMapper::erase(const IndexRange& _range)
+{
+    IndexRange range = IndexRangeList::validate(_range);
+
+    if (range.empty())
+        return;
+
+    _edit();
+    _split(range.location + 1);
+    _split(range.getMax());
+
+    std::size_t left = NONE;
+    std::size_t erased = NONE;
+    std::size_t right = NONE;
+
+    _splitTree(_root, range.location + 1, left, right);
+    _splitTree(right, range.getMax(), erased, right);
+
+    // The erased pieces all collapse onto the start of the range, so they
+    // are replaced by a single piece.
+    if (erased != NONE)
+    {
+        Piece piece;
+        piece.source = _nodes[_first(erased)].piece.source;
+        piece.target = range.location;
+        piece.erased = true;
+        erased = _newNode(piece);
+    }
+
+    // Subtracting is adding the two's complement. Lost pieces stay at MAX.
+    _apply(right, false, std::size_t(0) - range.size);
+
+    _root = _merge(_merge(left, erased), right);
+}
+
+
+void IndexRangeMapper::apply(const IndexRangeEdit& edit)
+{
+    if (edit.type == IndexRangeEdit::Type::INSERT)
+        insert(edit.range);
+    else
+        erase(edit.range);
+}
+
+
+void IndexRangeMapper::clear()
+{
+    _pieces.assign(1, Piece());
+    _firstLost = 1;
+    _compiled = true;
+    _nodes.clear();
+    _root = NONE;
+}
+
+
+bool IndexRangeMapper::isIdentity() const
+{
+    _compile();
+
+    return _pieces.size() == 1
+        && !_pieces[0].erased
+        && _pieces[0].target == 0;
+}
+
+
+std::size_t IndexRangeMapper::size() const
+{
+    _compile();
+
+    return _pieces.size();
+}
+
+
+bool IndexRangeMapper::isErased(std::size_t index) const
+{
+    _compile();
+
+    auto iter = std::upper_bound(_pieces.begin(),
+                                 _pieces.end(),
+                                 index,
+                                 [](std::size_t i, const Piece& piece) {
+                                     return i < piece.source;
+                                 });
+
+    return (iter - 1)->erased;
+}
+
+
+bool IndexRangeMapper::isLost(std::size_t index) const
+{
+    _compile();
+
+    return _firstLost < _pieces.size() && index >= _pieces[_firstLost].source;
+}
+
+
+std::size_t IndexRangeMapper::map(std::size_t index, Policy policy) const
+{
+    _compile();
+
+    auto iter = std::upper_bound(_pieces.begin(),
+                                 _pieces.end(),
+                                 index,
+                                 [](std::size_t i, const Piece& piece) {
+                                     return i < piece.source;
+                                 });
+
+    return _map(*(iter - 1), index, policy);
+}
+
+
+void IndexRangeMapper::map(const std::size_t* input,
+                           std::size_t* output,
+                           std::size_t count,
+                           Policy policy) const
+{
+    _compile();
+
+    if (std::is_sorted(input, input + count))
+    {
+        std::size_t piece = 0;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::size_t index = input[i];
+
+            while (piece + 1 < _pieces.size() && _pieces[piece + 1].source <= index)
+                ++piece;
+
+            output[i] = _map(_pieces[piece], index, policy);
+        }
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            output[i] = map(input[i], policy);
+    }
+}
+
+
+std::vector<std::size_t> IndexRangeMapper::map(const std::vector<std::size_t>& indices,
+                                               Policy policy) const
+{
+    std::vector<std::size_t> results(indices.size());
+    map(indices.data(), results.data(), indices.size(), policy);
+    return results;
+}
+
+
+std::size_t IndexRangeMapper::_map(const Piece& piece,
+                                   std::size_t index,
+                                   Policy policy)
+{
+    if (piece.erased)
+        return policy == Policy::INVALID ? IndexRange::MAX : piece.target;
+
+    if (piece.lost)
+        return IndexRange::MAX;
+
+    std::size_t offset = index - piece.source;
+
+    if (piece.target > IndexRange::MAX - offset)
+        return IndexRange::MAX;
+
+    return piece.target + offset;
+}
+
+
+void IndexRangeMapper::_edit()
+{
+    if (_root != NONE)
+        return;
+
+    // Build the tree from the sorted pieces in O(n), keeping the nodes on
+    // the right spine on a stack.
+    _nodes.clear();
+    _nodes.reserve(_pieces.size());
+
+    std::vector<std::size_t> spine;
+
+    for (auto& piece: _pieces)
+    {
+        std::size_t node = _newNode(piece);
+        std::size_t last = NONE;
+
+        while (!spine.empty() && _nodes[spine.back()].priority < _nodes[node].priority)
+        {
+            last = spine.back();
+            spine.pop_back();
+        }
+
+        _nodes[node].left = last;
+
+        if (!spine.empty())
+            _nodes[spine.back()].right = node;
+
+        spine.push_back(node);
+    }
+
+    _root = spine.front();
+}
+
+
+void IndexRangeMapper::_compile() const
+{
+    if (_compiled)
+        return;
+
+    _pieces.clear();
+    _collect(_root);
+    _compact();
+    _compiled = true;
+
+    // Targets never decrease, so every insert loses a suffix of the pieces.
+    _firstLost = _pieces.size();
+
+    while (_firstLost > 0 && _pieces[_firstLost - 1].lost)
+        --_firstLost;
+
+    // Drop a tree with many cut or redundant nodes. It is rebuilt from the
+    // compacted pieces by the next edit.
+    if (_nodes.size() > 2 * _pieces.size() + 16)
+    {
+        _nodes.clear();
+        _root = NONE;
+    }
+}
+
+
+void IndexRangeMapper::_collect(std::size_t node) const
+{
+    if (node == NONE)
+        return;
+
+    _push(node);
+    _collect(_nodes[node].left);
+    _pieces.push_back(_nodes[node].piece);
+    _collect(_nodes[node].right);
+}
+
+
+std::size_t IndexRangeMapper::_newNode(const Piece& piece)
+{
+    Node node;
+    node.piece = piece;
+    node.priority = mixPriority(_nodes.size());
+    _nodes.push_back(node);
+    _compiled = false;
+    return _nodes.size() - 1;
+}
+
+
+void IndexRangeMapper::_apply(std::size_t node, bool lose, std::size_t shift) const
+{
+    if (node == NONE)
+        return;
+
+    Node& n = _nodes[node];
+
+    if (lose)
+    {
+        n.piece.target = IndexRange::MAX;
+        n.piece.lost = true;
+    }
+    else if (!n.piece.lost)
+    {
+        n.piece.target += shift;
+    }
+
+    n.lose = n.lose || lose;
+    n.shift += shift;
+    _compiled = false;
+}
+
+
+void IndexRangeMapper::_push(std::size_t node) const
+{
+    Node& n = _nodes[node];
+
+    if (n.lose || n.shift != 0)
+    {
+        _apply(n.left, n.lose, n.shift);
+        _apply(n.right, n.lose, n.shift);
+        n.lose = false;
+        n.shift = 0;
+    }
+}
+
+
+void IndexRangeMapper::_splitTree(std::size_t node,
+                                  std::size_t value,
+                                  std::size_t& left,
+                                  std::size_t& right)
+{
+    if (node == NONE)
+    {
+        left = NONE;
+        right = NONE;
+        return;
+    }
+
+    _push(node);
+
+    // Targets are sorted, so the split keeps the order of the pieces.
+    if (_nodes[node].piece.target < value)
+    {
+        _splitTree(_nodes[node].right, value, _nodes[node].right, right);
+        left = node;
+    }
+    else
+    {
+        _splitTree(_nodes[node].left, value, left, _nodes[node].left);
+        right = node;
+    }
+}
+
+
+std::size_t IndexRangeMapper::_merge(std::size_t left, std::size_t right)
+{
+    if (left == NONE)
+        return right;
+
+    if (right == NONE)
+        return left;
+
+    if (_nodes[left].priority > _nodes[right].priority)
+    {
+        _push(left);
+        _nodes[left].right = _merge(_nodes[left].right, right);
+        return left;
+    }
+
+    _push(right);
+    _nodes[right].left = _merge(left, _nodes[right].left);
+    return right;
+}
+
+
+std::size_t IndexRangeMapper::_first(std::size_t node)
+{
+    for (_push(node); _nodes[node].left != NONE; _push(node))
+        node = _nodes[node].left;
+
+    return node;
+}
+
+
+std::size_t IndexRangeMapper::_last(std::size_t node)
+{
+    for (_push(node); _nodes[node].right != NONE; _push(node))
+        node = _nodes[node].right;
+
+    return node;
+}
+
+
+void IndexRangeMapper::_split(std::size_t value)
+{
+    std::size_t left = NONE;
+    std::size_t right = NONE;
+
+    _splitTree(_root, value, left, right);
+
+    if (left != NONE)
+    {
+        Piece previous = _nodes[_last(left)].piece;
+
+        // Erased and lost pieces map to a single value, so there is nothing
+        // to split.
+        std::size_t offset = value - previous.target;
+
+        if (!previous.erased && !previous.lost && offset <= IndexRange::MAX - previous.source)
+        {
+            std::size_t source = previous.source + offset;
+
+            if (right == NONE || source < _nodes[_first(right)].piece.source)
+            {
+                Piece piece;
+                piece.source = source;
+                piece.target = value;
+                left = _merge(left, _newNode(piece));
+            }
+        }
+    }
+
+    _root = _merge(left, right);
+}
+
+
+void IndexRangeMapper::_compact() const
+{
+    std::size_t count = 1;
+
+    for (std::size_t i = 1; i < _pieces.size(); ++i)
+    {
+        const Piece& previous = _pieces[count - 1];
+        const Piece& piece = _pieces[i];
+
+        bool merge = false;
+
+        if (previous.erased != piece.erased || previous.lost != piece.lost)
+            merge = false;
+        else if (piece.erased || piece.lost)
+            merge = previous.target == piece.target;
+        else
+        {
+            std::size_t offset = piece.source - previous.source;
+            merge = previous.target <= IndexRange::MAX - offset
+                 && previous.target + offset == piece.target;
+        }
+
+        if (!merge)
+            _pieces[count++] = piece;
+    }
+
+    _pieces.resize(count);
+}
+
+
+} // namespace ofx
@@ -0,0 +1,233 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/IndexRangeParallel.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace ofx {
+
+
+namespace {
+
+
+std::atomic<std::size_t> sNumThreads(0);
+std::atomic<std::size_t> sThreshold(1 << 16);
+
+
+/// \brief A call to IndexRangeParallel::forEach().
+struct Job
+{
+    /// \brief The number of tasks.
+    std::size_t count = 0;
+
+    /// \brief The task to run.
+    const std::function<void(std::size_t)>* task = nullptr;
+
+    /// \brief The next task to hand out.
+    std::atomic<std::size_t> next;
+
+    /// \brief The number of pool threads that may still join the job.
+    std::size_t numHelpers = 0;
+
+    /// \brief The number of pool threads running the job.
+    std::size_t numActive = 0;
+
+    /// \brief The first exception thrown by a task.
+    std::exception_ptr error;
+
+};
+
+
+/// \brief A persistent set of threads that help run forEach() jobs.
+///
+/// Threads are started on first use and are reused by later calls. The
+/// calling thread always runs tasks of its own job, so a job finishes even
+/// if every pool thread is busy, including when forEach() is nested.
+class Pool
+{
+public:
+    ~Pool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+
+        _wake.notify_all();
+
+        for (auto& thread: _threads)
+            thread.join();
+    }
+
+    /// \brief Run a job on the calling thread and up to numHelpers pool
+    ///        threads, then rethrow the first exception thrown by a task.
+    void run(Job& job)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            while (_threads.size() < job.numHelpers)
+                _threads.push_back(std::thread(&Pool::_loop, this));
+
+            _jobs.push_back(&job);
+        }
+
+        _wake.notify_all();
+
+        _runTasks(job);
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            // No task is left, so threads that have not joined yet never will.
+            auto iter = std::find(_jobs.begin(), _jobs.end(), &job);
+
+            if (iter != _jobs.end())
+                _jobs.erase(iter);
+
+            _finished.wait(lock, [&]() { return job.numActive == 0; });
+        }
+
+        if (job.error)
+            std::rethrow_exception(job.error);
+    }
+
+private:
+    void _loop()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        for (;;)
+        {
+            _wake.wait(lock, [&]() { return _stopping || !_jobs.empty(); });
+
+            if (_stopping)
+                return;
+
+            Job& job = *_jobs.front();
+            ++job.numActive;
+
+            if (--job.numHelpers == 0)
+                _jobs.pop_front();
+
+            lock.unlock();
+            _runTasks(job);
+            lock.lock();
+
+            if (--job.numActive == 0)
+                _finished.notify_all();
+        }
+    }
+
+    void _runTasks(Job& job)
+    {
+        for (std::size_t i = job.next++; i < job.count; i = job.next++)
+        {
+            try
+            {
+                (*job.task)(i);
+            }
+            catch (...)
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+
+                if (!job.error)
+                    job.error = std::current_exception();
+
+                // Skip the remaining tasks.
+                job.next = job.count;
+            }
+        }
+    }
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _finished;
+    std::deque<Job*> _jobs;
+    std::vector<std::thread> _threads;
+    bool _stopping = false;
+
+};
+
+
+Pool& pool()
+{
+    static Pool sPool;
+    return sPool;
+}
+
+
+} // namespace
+
+
+void IndexRangeParallel::setNumThreads(std::size_t numThreads)
+{
+    sNumThreads = numThreads;
+}
+
+
+std::size_t IndexRangeParallel::numThreads()
+{
+    std::size_t result = sNumThreads;
+
+    if (result == 0)
+        result = std::max(1u, std::thread::hardware_concurrency());
+
+    return result;
+}
+
+
+void IndexRangeParallel::setThreshold(std::size_t threshold)
+{
+    sThreshold = threshold;
+}
+
+
+std::size_t IndexRangeParallel::threshold()
+{
+    return sThreshold;
+}
+
+
+bool IndexRangeParallel::isParallel(std::size_t count)
+{
+    return count >= threshold() && numThreads() > 1;
+}
+
+
+void IndexRangeParallel::forEach(std::size_t count,
+                                 const std::function<void(std::size_t)>& task)
+{
+    std::size_t numWorkers = std::min(count, numThreads());
+
+    if (numWorkers <= 1)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            task(i);
+
+        return;
+    }
+
+    Job job;
+    job.count = count;
+    job.task = &task;
+    job.next = 0;
+    job.numHelpers = numWorkers - 1;
+
+    pool().run(job);
+}
+
+
+} // namespace ofx
@@ -0,0 +1,355 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/IndexRangeRegion.h"
+
+
+namespace ofx {
+
+
+IndexRangeRect::IndexRangeRect()
+{
+}
+
+
+IndexRangeRect::IndexRangeRect(const IndexRange& _x, const IndexRange& _y):
+    x(_x),
+    y(_y)
+{
+}
+
+
+IndexRangeRect::IndexRangeRect(std::size_t _x,
+                               std::size_t _y,
+                               std::size_t width,
+                               std::size_t height):
+    IndexRangeRect(IndexRange(_x, width), IndexRange(_y, height))
+{
+}
+
+
+bool IndexRangeRect::empty() const
+{
+    return x.empty() || y.empty();
+}
+
+
+std::size_t IndexRangeRect::area() const
+{
+    return x.size * y.size;
+}
+
+
+bool IndexRangeRect::contains(std::size_t _x, std::size_t _y) const
+{
+    return x.contains(_x) && y.contains(_y);
+}
+
+
+IndexRangeRect IndexRangeRect::unionWith(const IndexRangeRect& other) const
+{
+    if (empty())
+        return other;
+
+    if (other.empty())
+        return *this;
+
+    return IndexRangeRect(x.unionWith(other.x), y.unionWith(other.y));
+}
+
+
+bool IndexRangeRect::operator == (const IndexRangeRect& other) const
+{
+    return x == other.x && y == other.y;
+}
+
+
+bool IndexRangeRect::operator != (const IndexRangeRect& other) const
+{
+    return !(*this == other);
+}
+
+
+IndexRangeRegion::IndexRangeRegion()
+{
+}
+
+
+IndexRangeRegion::IndexRangeRegion(const IndexRangeRect& _rect)
+{
+    IndexRangeRect rect(IndexRangeList::validate(_rect.x),
+                        IndexRangeList::validate(_rect.y));
+
+    if (!rect.empty())
+    {
+        Band band;
+        band.y = rect.y;
+        band.x.add(rect.x);
+        _bands.push_back(band);
+    }
+}
+
+
+void IndexRangeRegion::add(const IndexRangeRect& rect)
+{
+    add(IndexRangeRegion(rect));
+}
+
+
+void IndexRangeRegion::add(const IndexRangeRegion& other)
+{
+    *this = unionWith(other);
+}
+
+
+void IndexRangeRegion::remove(const IndexRangeRect& rect)
+{
+    remove(IndexRangeRegion(rect));
+}
+
+
+void IndexRangeRegion::remove(const IndexRangeRegion& other)
+{
+    *this = differenceWith(other);
+}
+
+
+void IndexRangeRegion::intersect(const IndexRangeRect& rect)
+{
+    intersect(IndexRangeRegion(rect));
+}
+
+
+void IndexRangeRegion::intersect(const IndexRangeRegion& other)
+{
+    *this = intersectionWith(other);
+}
+
+
+IndexRangeRegion IndexRangeRegion::unionWith(const IndexRangeRegion& other) const
+{
+    return _combine(*this, other, Operation::UNION);
+}
+
+
+IndexRangeRegion IndexRangeRegion::intersectionWith(const IndexRangeRegion& other) const
+{
+    return _combine(*this, other, Operation::INTERSECTION);
+}
+
+
+IndexRangeRegion IndexRangeRegion::differenceWith(const IndexRangeRegion& other) const
+{
+    return _combine(*this, other, Operation::DIFFERENCE);
+}
+
+
+void IndexRangeRegion::clear()
+{
+    _bands.clear();
+}
+
+
+bool IndexRangeRegion::empty() const
+{
+    return _bands.empty();
+}
+
+
+bool IndexRangeRegion::contains(std::size_t x, std::size_t y) const
+{
+    auto iter = std::upper_bound(_bands.begin(), _bands.end(), y, [](std::size_t _y, const Band& band) {
+        return _y < band.y.getMax();
+    });
+
+    return iter != _bands.end()
+        && iter->y.contains(y)
+        && iter->x.contains(x);
+}
+
+
+std::size_t IndexRangeRegion::area() const
+{
+    std::size_t result = 0;
+
+    for (auto& band: _bands)
+        result += band.y.size * band.x.cardinality();
+
+    return result;
+}
+
+
+IndexRangeRect IndexRangeRegion::bounds() const
+{
+    IndexRangeRect result;
+
+    for (auto& band: _bands)
+    {
+        std::vector<IndexRange> ranges = band.x.ranges();
+        IndexRange x = ranges.front().unionWith(ranges.back());
+        result = result.unionWith(IndexRangeRect(x, band.y));
+    }
+
+    return result;
+}
+
+
+std::vector<IndexRangeRect> IndexRangeRegion::rects() const
+{
+    std::vector<IndexRangeRect> results;
+
+    for (auto& band: _bands)
+        for (auto& x: band.x.ranges())
+            results.push_back(IndexRangeRect(x, band.y));
+
+    return results;
+}
+
+
+std::vector<IndexRangeRect> IndexRangeRegion::rects(std::size_t maxCount) const
+{
+    std::vector<IndexRangeRect> results = rects();
+
+    maxCount = std::max(std::size_t(1), maxCount);
+
+    // The number of cells a merged rectangle covers beyond its two parts.
+    auto cost = [](const IndexRangeRect& a, const IndexRangeRect& b) {
+        std::size_t area = a.unionWith(b).area();
+        std::size_t parts = a.area() + b.area();
+        return area > parts ? area - parts : 0;
+    };
+
+    while (results.size() > maxCount)
+    {
+        std::size_t best = 0;
+        std::size_t bestCost = IndexRange::MAX;
+
+        for (std::size_t i = 0; i + 1 < results.size(); ++i)
+        {
+            std::size_t c = cost(results[i], results[i + 1]);
+
+            if (c < bestCost)
+            {
+                best = i;
+                bestCost = c;
+            }
+        }
+
+        results[best] = results[best].unionWith(results[best + 1]);
+        results.erase(results.begin() + best + 1);
+    }
+
+    return results;
+}
+
+
+bool IndexRangeRegion::operator == (const IndexRangeRegion& other) const
+{
+    if (_bands.size() != other._bands.size())
+        return false;
+
+    for (std::size_t i = 0; i < _bands.size(); ++i)
+    {
+        if (_bands[i].y != other._bands[i].y || _bands[i].x != other._bands[i].x)
+            return false;
+    }
+
+    return true;
+}
+
+
+bool IndexRangeRegion::operator != (const IndexRangeRegion& other) const
+{
+    return !(*this == other);
+}
+
+
+IndexRangeRegion IndexRangeRegion::_combine(const IndexRangeRegion& a,
+                                            const IndexRangeRegion& b,
+                                            Operation operation)
+{
+    // Every band edge of either region.
+    std::vector<std::size_t> edges;
+    edges.reserve(2 * (a._bands.size() + b._bands.size()));
+
+    for (auto& band: a._bands)
+    {
+        edges.push_back(band.y.getMin());
+        edges.push_back(band.y.getMax());
+    }
+
+    for (auto& band: b._bands)
+    {
+        edges.push_back(band.y.getMin());
+        edges.push_back(band.y.getMax());
+    }
+
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    IndexRangeRegion result;
+    const IndexRangeList empty;
+
+    auto aIter = a._bands.begin();
+    auto bIter = b._bands.begin();
+
+    // Combine each horizontal slice between two consecutive edges.
+    for (std::size_t i = 0; i + 1 < edges.size(); ++i)
+    {
+        IndexRange y = IndexRange::fromExclusiveInterval(edges[i], edges[i + 1]);
+
+        while (aIter != a._bands.end() && aIter->y.getMax() <= y.location)
+            ++aIter;
+
+        while (bIter != b._bands.end() && bIter->y.getMax() <= y.location)
+            ++bIter;
+
+        bool aCovers = aIter != a._bands.end() && aIter->y.location <= y.location;
+        bool bCovers = bIter != b._bands.end() && bIter->y.location <= y.location;
+
+        const IndexRangeList& ax = aCovers ? aIter->x : empty;
+        const IndexRangeList& bx = bCovers ? bIter->x : empty;
+
+        IndexRangeList x;
+
+        switch (operation)
+        {
+            case Operation::UNION:
+                x = ax.unionWith(bx);
+                break;
+            case Operation::INTERSECTION:
+                x = ax.intersectionWith(bx);
+                break;
+            case Operation::DIFFERENCE:
+                x = ax.differenceWith(bx);
+                break;
+        }
+
+        if (x.empty())
+            continue;
+
+        // Coalesce with the band above if it touches and has the same columns.
+        if (!result._bands.empty()
+        && result._bands.back().y.getMax() == y.location
+        && result._bands.back().x == x)
+        {
+            result._bands.back().y.setMax(y.getMax());
+        }
+        else
+        {
+            Band band;
+            band.y = y;
+            band.x = x;
+            result._bands.push_back(band);
+        }
+    }
+
+    return result;
+}
+
+
+} // namespace ofx
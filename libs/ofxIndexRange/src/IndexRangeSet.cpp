@@ -0,0 +1,1059 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/IndexRangeSet.h"
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace ofx {
+
+
+const std::size_t IndexRangeSet::CHUNK_BITS;
+const std::size_t IndexRangeSet::CHUNK_SIZE;
+const std::size_t IndexRangeSet::MAX_ARRAY_SIZE;
+
+
+namespace {
+
+
+typedef IndexRangeSetChunk Chunk;
+typedef IndexRangeSetChunk::Type Type;
+
+
+/// \brief The binary set operations.
+enum class Operation
+{
+    UNION,
+    INTERSECTION,
+    DIFFERENCE
+};
+
+
+/// \brief The number of bits in a bitmap word.
+const std::size_t WORD_BITS = 64;
+
+
+/// \brief The number of words in a chunk bitmap.
+const std::size_t NUM_WORDS = IndexRangeSet::CHUNK_SIZE / WORD_BITS;
+
+
+/// \returns the index of the lowest set bit of a non-zero word.
+inline std::size_t countTrailingZeros(uint64_t word)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, word);
+    return index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+
+/// \returns the number of set bits in a word.
+inline std::size_t popCount(uint64_t word)
+{
+#if defined(_MSC_VER)
+    return std::size_t(__popcnt64(word));
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+
+/// \brief Append a run, merging it with the last run if they touch.
+void appendMerged(std::vector<IndexRange>& runs, const IndexRange& run)
+{
+    if (run.empty())
+        return;
+
+    if (!runs.empty() && runs.back().getMax() >= run.location)
+    {
+        if (run.getMax() > runs.back().getMax())
+            runs.back().setMax(run.getMax());
+    }
+    else
+    {
+        runs.push_back(run);
+    }
+}
+
+
+/// \brief Set or clear the bits in [first, last).
+void setBits(std::vector<uint64_t>& bitmap,
+             std::size_t first,
+             std::size_t last,
+             bool value)
+{
+    if (first >= last)
+        return;
+
+    std::size_t firstWord = first / WORD_BITS;
+    std::size_t lastWord = (last - 1) / WORD_BITS;
+
+    for (std::size_t i = firstWord; i <= lastWord; ++i)
+    {
+        uint64_t mask = ~uint64_t(0);
+
+        if (i == firstWord)
+            mask &= ~uint64_t(0) << (first % WORD_BITS);
+
+        if (i == lastWord && last % WORD_BITS != 0)
+            mask &= (uint64_t(1) << (last % WORD_BITS)) - 1;
+
+        if (value)
+            bitmap[i] |= mask;
+        else
+            bitmap[i] &= ~mask;
+    }
+}
+
+
+/// \returns true if bit i is set.
+inline bool testBit(const std::vector<uint64_t>& bitmap, std::size_t i)
+{
+    return (bitmap[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+}
+
+
+/// \brief Call f(first, last) for each run of a chunk, in order.
+template <typename Function>
+void forEachRun(const Chunk& chunk, Function f)
+{
+    switch (chunk.type)
+    {
+        case Type::ARRAY:
+        {
+            std::size_t i = 0;
+
+            while (i < chunk.array.size())
+            {
+                std::size_t first = chunk.array[i];
+                std::size_t last = first + 1;
+
+                while (++i < chunk.array.size() && chunk.array[i] == last)
+                    ++last;
+
+                f(first, last);
+            }
+            break;
+        }
+        case Type::BITMAP:
+        {
+            std::size_t start = 0;
+            uint64_t carry = 0;
+            bool inRun = false;
+
+            for (std::size_t i = 0; i < NUM_WORDS; ++i)
+            {
+                uint64_t word = chunk.bitmap[i];
+                uint64_t transitions = word ^ ((word << 1) | carry);
+                carry = word >> (WORD_BITS - 1);
+
+                while (transitions != 0)
+                {
+                    std::size_t index = i * WORD_BITS + countTrailingZeros(transitions);
+
+                    if (inRun)
+                        f(start, index);
+                    else
+                        start = index;
+
+                    inRun = !inRun;
+                    transitions &= transitions - 1;
+                }
+            }
+
+            if (inRun)
+                f(start, IndexRangeSet::CHUNK_SIZE);
+            break;
+        }
+        case Type::RUN:
+        {
+            for (auto& run: chunk.runs)
+                f(run.location, run.getMax());
+            break;
+        }
+    }
+}
+
+
+/// \returns the number of runs in a chunk.
+std::size_t countRuns(const Chunk& chunk)
+{
+    switch (chunk.type)
+    {
+        case Type::ARRAY:
+        {
+            std::size_t count = chunk.array.empty() ? 0 : 1;
+
+            for (std::size_t i = 1; i < chunk.array.size(); ++i)
+            {
+                if (chunk.array[i] != chunk.array[i - 1] + 1)
+                    ++count;
+            }
+
+            return count;
+        }
+        case Type::BITMAP:
+        {
+            // Count the bits that start a run.
+            std::size_t count = 0;
+            uint64_t carry = 0;
+
+            for (auto word: chunk.bitmap)
+            {
+                count += popCount(word & ~((word << 1) | carry));
+                carry = word >> (WORD_BITS - 1);
+            }
+
+            return count;
+        }
+        case Type::RUN:
+            return chunk.runs.size();
+    }
+
+    return 0;
+}
+
+
+/// \returns the number of bytes used to store a chunk as the given type.
+std::size_t bytesFor(Type type, std::size_t cardinality, std::size_t numRuns)
+{
+    switch (type)
+    {
+        case Type::ARRAY:
+            return cardinality * sizeof(uint16_t);
+        case Type::BITMAP:
+            return NUM_WORDS * sizeof(uint64_t);
+        case Type::RUN:
+            return numRuns * sizeof(IndexRange);
+    }
+
+    return 0;
+}
+
+
+/// \brief Recount the indices of a chunk from its storage.
+void updateCardinality(Chunk& chunk)
+{
+    chunk.cardinality = 0;
+
+    switch (chunk.type)
+    {
+        case Type::ARRAY:
+            chunk.cardinality = chunk.array.size();
+            break;
+        case Type::BITMAP:
+            for (auto word: chunk.bitmap)
+                chunk.cardinality += popCount(word);
+            break;
+        case Type::RUN:
+            for (auto& run: chunk.runs)
+                chunk.cardinality += run.size;
+            break;
+    }
+}
+
+
+/// \brief Convert a chunk to another storage type.
+void convert(Chunk& chunk, Type type)
+{
+    if (chunk.type == type)
+        return;
+
+    switch (type)
+    {
+        case Type::ARRAY:
+        {
+            chunk.array.reserve(chunk.cardinality);
+            forEachRun(chunk, [&](std::size_t first, std::size_t last) {
+                for (std::size_t i = first; i < last; ++i)
+                    chunk.array.push_back(uint16_t(i));
+            });
+            break;
+        }
+        case Type::BITMAP:
+        {
+            chunk.bitmap.assign(NUM_WORDS, 0);
+            forEachRun(chunk, [&](std::size_t first, std::size_t last) {
+                setBits(chunk.bitmap, first, last, true);
+            });
+            break;
+        }
+        case Type::RUN:
+        {
+            forEachRun(chunk, [&](std::size_t first, std::size_t last) {
+                chunk.runs.push_back(IndexRange::fromExclusiveInterval(first, last));
+            });
+            break;
+        }
+    }
+
+    // Release the storage of the previous type.
+    if (chunk.type == Type::ARRAY)
+        std::vector<uint16_t>().swap(chunk.array);
+    else if (chunk.type == Type::BITMAP)
+        std::vector<uint64_t>().swap(chunk.bitmap);
+    else
+        std::vector<IndexRange>().swap(chunk.runs);
+
+    chunk.type = type;
+}
+
+
+/// \brief Convert a chunk to its smallest storage type.
+void optimize(Chunk& chunk)
+{
+    std::size_t numRuns = countRuns(chunk);
+    Type best = Type::RUN;
+
+    for (Type type: { Type::ARRAY, Type::BITMAP })
+    {
+        if (bytesFor(type, chunk.cardinality, numRuns) < bytesFor(best, chunk.cardinality, numRuns))
+            best = type;
+    }
+
+    convert(chunk, best);
+}
+
+
+/// \returns a copy of a chunk stored as the given type.
+Chunk convertedCopy(const Chunk& chunk, Type type)
+{
+    Chunk result = chunk;
+    convert(result, type);
+    return result;
+}
+
+
+/// \brief Combine two sorted, merged run lists.
+std::vector<IndexRange> combineRuns(const std::vector<IndexRange>& a,
+                                    const std::vector<IndexRange>& b,
+                                    Operation operation)
+{
+    std::vector<IndexRange> results;
+
+    auto aIter = a.begin();
+    auto bIter = b.begin();
+
+    switch (operation)
+    {
+        case Operation::UNION:
+        {
+            while (aIter != a.end() || bIter != b.end())
+            {
+                if (bIter == b.end() || (aIter != a.end() && aIter->location < bIter->location))
+                    appendMerged(results, *aIter++);
+                else
+                    appendMerged(results, *bIter++);
+            }
+            break;
+        }
+        case Operation::INTERSECTION:
+        {
+            while (aIter != a.end() && bIter != b.end())
+            {
+                appendMerged(results, aIter->intersectionWith(*bIter));
+
+                if (aIter->getMax() < bIter->getMax())
+                    ++aIter;
+                else
+                    ++bIter;
+            }
+            break;
+        }
+        case Operation::DIFFERENCE:
+        {
+            for (; aIter != a.end(); ++aIter)
+            {
+                std::size_t location = aIter->location;
+
+                while (bIter != b.end() && bIter->getMax() <= location)
+                    ++bIter;
+
+                for (auto iter = bIter; iter != b.end() && iter->location < aIter->getMax(); ++iter)
+                {
+                    if (iter->location > location)
+                        results.push_back(IndexRange::fromExclusiveInterval(location, iter->location));
+
+                    location = std::max(location, iter->getMax());
+                }
+
+                if (location < aIter->getMax())
+                    results.push_back(IndexRange::fromExclusiveInterval(location, aIter->getMax()));
+            }
+            break;
+        }
+    }
+
+    return results;
+}
+
+
+/// \brief Keep the array values for which keep(value) is true.
+template <typename Predicate>
+std::vector<uint16_t> filterArray(const std::vector<uint16_t>& array, Predicate keep)
+{
+    std::vector<uint16_t> results;
+    results.reserve(array.size());
+
+    for (auto value: array)
+    {
+        if (keep(value))
+            results.push_back(value);
+    }
+
+    return results;
+}
+
+
+/// \brief Combine two chunks with the same key.
+///
+/// Each pair of storage types uses a dedicated path. The result is
+/// converted to its smallest storage type.
+Chunk combineChunks(const Chunk& a, const Chunk& b, Operation operation)
+{
+    Chunk result;
+    result.key = a.key;
+
+    if (a.type == Type::ARRAY && b.type == Type::ARRAY)
+    {
+        result.type = Type::ARRAY;
+        auto out = std::back_inserter(result.array);
+
+        if (operation == Operation::UNION)
+            std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), out);
+        else if (operation == Operation::INTERSECTION)
+            std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), out);
+        else
+            std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), out);
+    }
+    else if (a.type == Type::RUN && b.type == Type::RUN)
+    {
+        result.type = Type::RUN;
+        result.runs = combineRuns(a.runs, b.runs, operation);
+    }
+    else if (a.type == Type::ARRAY && b.type == Type::BITMAP && operation != Operation::UNION)
+    {
+        // Filter the array by the bitmap.
+        bool keep = operation == Operation::INTERSECTION;
+        result.type = Type::ARRAY;
+        result.array = filterArray(a.array, [&](uint16_t value) {
+            return testBit(b.bitmap, value) == keep;
+        });
+    }
+    else if (a.type == Type::BITMAP && b.type == Type::ARRAY && operation == Operation::INTERSECTION)
+    {
+        result.type = Type::ARRAY;
+        result.array = filterArray(b.array, [&](uint16_t value) {
+            return testBit(a.bitmap, value);
+        });
+    }
+    else if ((a.type == Type::ARRAY || b.type == Type::ARRAY)
+          && (a.type == Type::BITMAP || b.type == Type::BITMAP))
+    {
+        // Union with an array, or a bitmap minus an array: update a copy of
+        // the bitmap in place.
+        const Chunk& bitmap = a.type == Type::BITMAP ? a : b;
+        const Chunk& array = a.type == Type::ARRAY ? a : b;
+        bool value = operation == Operation::UNION;
+
+        result.type = Type::BITMAP;
+        result.bitmap = bitmap.bitmap;
+
+        for (auto index: array.array)
+        {
+            if (value)
+                result.bitmap[index / WORD_BITS] |= uint64_t(1) << (index % WORD_BITS);
+            else
+                result.bitmap[index / WORD_BITS] &= ~(uint64_t(1) << (index % WORD_BITS));
+        }
+    }
+    else if (a.type == Type::BITMAP || b.type == Type::BITMAP)
+    {
+        // Bitmaps and runs are combined a word at a time. Runs are first
+        // expanded to a bitmap with whole-word fills.
+        Chunk aBitmap = a.type == Type::BITMAP ? Chunk() : convertedCopy(a, Type::BITMAP);
+        Chunk bBitmap = b.type == Type::BITMAP ? Chunk() : convertedCopy(b, Type::BITMAP);
+        const std::vector<uint64_t>& aWords = a.type == Type::BITMAP ? a.bitmap : aBitmap.bitmap;
+        const std::vector<uint64_t>& bWords = b.type == Type::BITMAP ? b.bitmap : bBitmap.bitmap;
+
+        result.type = Type::BITMAP;
+        result.bitmap.resize(NUM_WORDS);
+
+        for (std::size_t i = 0; i < NUM_WORDS; ++i)
+        {
+            if (operation == Operation::UNION)
+                result.bitmap[i] = aWords[i] | bWords[i];
+            else if (operation == Operation::INTERSECTION)
+                result.bitmap[i] = aWords[i] & bWords[i];
+            else
+                result.bitmap[i] = aWords[i] & ~bWords[i];
+        }
+    }
+    else if (a.type == Type::ARRAY && operation != Operation::UNION)
+    {
+        // Filter the array by the runs.
+        bool keep = operation == Operation::INTERSECTION;
+        auto run = b.runs.begin();
+
+        result.type = Type::ARRAY;
+        result.array = filterArray(a.array, [&](uint16_t value) {
+            while (run != b.runs.end() && run->getMax() <= value)
+                ++run;
+
+            return (run != b.runs.end() && run->location <= value) == keep;
+        });
+    }
+    else if (b.type == Type::ARRAY && operation == Operation::INTERSECTION)
+    {
+        return combineChunks(b, a, operation);
+    }
+    else
+    {
+        // Union of an array and runs, or runs minus an array.
+        result.type = Type::RUN;
+        result.runs = combineRuns(a.type == Type::RUN ? a.runs : convertedCopy(a, Type::RUN).runs,
+                                  b.type == Type::RUN ? b.runs : convertedCopy(b, Type::RUN).runs,
+                                  operation);
+    }
+
+    updateCardinality(result);
+    optimize(result);
+    return result;
+}
+
+
+/// \brief Combine two sorted chunk lists.
+std::vector<Chunk> combineChunkLists(const std::vector<Chunk>& a,
+                                     const std::vector<Chunk>& b,
+                                     Operation operation)
+{
+    std::vector<Chunk> results;
+
+    auto aIter = a.begin();
+    auto bIter = b.begin();
+
+    while (aIter != a.end() || bIter != b.end())
+    {
+        if (bIter == b.end() || (aIter != a.end() && aIter->key < bIter->key))
+        {
+            if (operation != Operation::INTERSECTION)
+                results.push_back(*aIter);
+
+            ++aIter;
+        }
+        else if (aIter == a.end() || bIter->key < aIter->key)
+        {
+            if (operation == Operation::UNION)
+                results.push_back(*bIter);
+
+            ++bIter;
+        }
+        else
+        {
+            Chunk chunk = combineChunks(*aIter++, *bIter++, operation);
+
+            if (chunk.cardinality > 0)
+                results.push_back(std::move(chunk));
+        }
+    }
+
+    return results;
+}
+
+
+/// \returns a chunk with the single run [first, last).
+Chunk makeChunk(std::size_t key, std::size_t first, std::size_t last)
+{
+    Chunk chunk;
+    chunk.key = key;
+    chunk.type = Type::RUN;
+    chunk.runs.push_back(IndexRange::fromExclusiveInterval(first, last));
+    chunk.cardinality = last - first;
+    return chunk;
+}
+
+
+/// \brief Split a range into single-run chunks.
+std::vector<Chunk> makeChunks(const IndexRange& range)
+{
+    std::vector<Chunk> chunks;
+
+    if (range.empty())
+        return chunks;
+
+    std::size_t location = range.location;
+
+    while (location < range.getMax())
+    {
+        std::size_t key = location >> IndexRangeSet::CHUNK_BITS;
+        std::size_t base = key << IndexRangeSet::CHUNK_BITS;
+        std::size_t max = std::min(range.getMax() - base, IndexRangeSet::CHUNK_SIZE);
+
+        chunks.push_back(makeChunk(key, location - base, max));
+
+        location = base + max;
+    }
+
+    return chunks;
+}
+
+
+/// \brief Set or clear the indices [first, last) of a chunk in place.
+///
+/// The chunk is converted to its smallest storage type afterwards.
+void setRange(Chunk& chunk, std::size_t first, std::size_t last, bool value)
+{
+    switch (chunk.type)
+    {
+        case Type::ARRAY:
+        {
+            auto begin = std::lower_bound(chunk.array.begin(), chunk.array.end(), first);
+            auto end = std::lower_bound(begin, chunk.array.end(), last);
+            begin = chunk.array.erase(begin, end);
+
+            if (!value)
+                break;
+
+            if (chunk.array.size() + (last - first) <= IndexRangeSet::MAX_ARRAY_SIZE)
+            {
+                std::size_t offset = begin - chunk.array.begin();
+                chunk.array.insert(begin, last - first, 0);
+                std::iota(chunk.array.begin() + offset,
+                          chunk.array.begin() + offset + (last - first),
+                          uint16_t(first));
+                break;
+            }
+
+            // Too many indices for an array.
+            convert(chunk, Type::BITMAP);
+            setBits(chunk.bitmap, first, last, true);
+            break;
+        }
+        case Type::BITMAP:
+            setBits(chunk.bitmap, first, last, value);
+            break;
+        case Type::RUN:
+            chunk.runs = combineRuns(chunk.runs,
+                                     { IndexRange::fromExclusiveInterval(first, last) },
+                                     value ? Operation::UNION : Operation::DIFFERENCE);
+            break;
+    }
+
+    updateCardinality(chunk);
+    optimize(chunk);
+}
+
+
+/// \brief Add or remove a range, touching only the chunks it overlaps.
+///
+/// The first affected chunk is found by binary search. Chunks fully covered
+/// by the range are replaced or erased without being read, and the chunks
+/// after the range are moved only if the number of chunks changes.
+void updateChunks(std::vector<Chunk>& chunks, const IndexRange& range, bool value)
+{
+    if (range.empty())
+        return;
+
+    std::size_t firstKey = range.location >> IndexRangeSet::CHUNK_BITS;
+    std::size_t lastKey = (range.getMax() - 1) >> IndexRangeSet::CHUNK_BITS;
+
+    auto byKey = [](const Chunk& chunk, std::size_t key) {
+        return chunk.key < key;
+    };
+
+    auto first = std::lower_bound(chunks.begin(), chunks.end(), firstKey, byKey);
+    auto last = std::lower_bound(first, chunks.end(), lastKey + 1, byKey);
+
+    // The part of the range in the chunk with the given key.
+    auto span = [&](std::size_t key) {
+        std::size_t base = key << IndexRangeSet::CHUNK_BITS;
+        return IndexRange::fromExclusiveInterval(std::max(range.location, base) - base,
+                                                 std::min(range.getMax() - base, IndexRangeSet::CHUNK_SIZE));
+    };
+
+    if (!value)
+    {
+        for (auto iter = first; iter != last; ++iter)
+        {
+            IndexRange cleared = span(iter->key);
+
+            if (cleared.size == IndexRangeSet::CHUNK_SIZE)
+                iter->cardinality = 0;
+            else
+                setRange(*iter, cleared.location, cleared.getMax(), false);
+        }
+
+        chunks.erase(std::remove_if(first, last, [](const Chunk& chunk) {
+            return chunk.cardinality == 0;
+        }), last);
+
+        return;
+    }
+
+    // Every existing chunk in [first, last) has a key in the range, so the
+    // updated chunks are a superset of them.
+    std::vector<Chunk> updated;
+    auto iter = first;
+
+    for (std::size_t key = firstKey; key <= lastKey; ++key)
+    {
+        IndexRange added = span(key);
+
+        if (iter != last && iter->key == key && added.size < IndexRangeSet::CHUNK_SIZE)
+        {
+            setRange(*iter, added.location, added.getMax(), true);
+            updated.push_back(std::move(*iter));
+        }
+        else
+        {
+            updated.push_back(makeChunk(key, added.location, added.getMax()));
+        }
+
+        if (iter != last && iter->key == key)
+            ++iter;
+    }
+
+    std::size_t offset = first - chunks.begin();
+    std::size_t count = last - first;
+
+    std::move(updated.begin(), updated.begin() + count, first);
+    chunks.insert(chunks.begin() + offset + count,
+                  std::make_move_iterator(updated.begin() + count),
+                  std::make_move_iterator(updated.end()));
+}
+
+
+} // namespace
+
+
+IndexRangeSet::IndexRangeSet()
+{
+}
+
+
+IndexRangeSet::IndexRangeSet(const IndexRangeList& list)
+{
+    for (auto& range: list.ranges())
+    {
+        for (auto& chunk: makeChunks(IndexRangeList::validate(range)))
+        {
+            // Ranges are sorted, so only the last chunk can be shared.
+            if (!_chunks.empty() && _chunks.back().key == chunk.key)
+            {
+                _chunks.back().runs.push_back(chunk.runs[0]);
+                _chunks.back().cardinality += chunk.cardinality;
+            }
+            else
+            {
+                _chunks.push_back(std::move(chunk));
+            }
+        }
+    }
+
+    optimize();
+}
+
+
+void IndexRangeSet::add(std::size_t index)
+{
+    std::size_t key = index >> CHUNK_BITS;
+    uint16_t value = uint16_t(index & (CHUNK_SIZE - 1));
+
+    auto iter = std::lower_bound(_chunks.begin(),
+                                 _chunks.end(),
+                                 key,
+                                 [](const Chunk& chunk, std::size_t k) {
+                                     return chunk.key < k;
+                                 });
+
+    if (iter == _chunks.end() || iter->key != key)
+    {
+        Chunk chunk;
+        chunk.key = key;
+        iter = _chunks.insert(iter, std::move(chunk));
+    }
+
+    Chunk& chunk = *iter;
+
+    switch (chunk.type)
+    {
+        case Type::ARRAY:
+        {
+            auto position = std::lower_bound(chunk.array.begin(), chunk.array.end(), value);
+
+            if (position == chunk.array.end() || *position != value)
+            {
+                chunk.array.insert(position, value);
+                ++chunk.cardinality;
+
+                if (chunk.cardinality > MAX_ARRAY_SIZE)
+                    convert(chunk, Type::BITMAP);
+            }
+            break;
+        }
+        case Type::BITMAP:
+        {
+            if (!testBit(chunk.bitmap, value))
+            {
+                chunk.bitmap[value / WORD_BITS] |= uint64_t(1) << (value % WORD_BITS);
+                ++chunk.cardinality;
+            }
+            break;
+        }
+        case Type::RUN:
+        {
+            setRange(chunk, value, value + 1, true);
+            break;
+        }
+    }
+}
+
+
+void IndexRangeSet::add(const IndexRange& range)
+{
+    updateChunks(_chunks, IndexRangeList::validate(range), true);
+}
+
+
+void IndexRangeSet::remove(std::size_t index)
+{
+    Chunk* chunk = _find(index >> CHUNK_BITS);
+
+    if (chunk == nullptr)
+        return;
+
+    uint16_t value = uint16_t(index & (CHUNK_SIZE - 1));
+
+    switch (chunk->type)
+    {
+        case Type::ARRAY:
+        {
+            auto position = std::lower_bound(chunk->array.begin(), chunk->array.end(), value);
+
+            if (position != chunk->array.end() && *position == value)
+            {
+                chunk->array.erase(position);
+                --chunk->cardinality;
+            }
+            break;
+        }
+        case Type::BITMAP:
+        {
+            if (testBit(chunk->bitmap, value))
+            {
+                chunk->bitmap[value / WORD_BITS] &= ~(uint64_t(1) << (value % WORD_BITS));
+                --chunk->cardinality;
+
+                if (chunk->cardinality <= MAX_ARRAY_SIZE)
+                    convert(*chunk, Type::ARRAY);
+            }
+            break;
+        }
+        case Type::RUN:
+        {
+            setRange(*chunk, value, value + 1, false);
+            break;
+        }
+    }
+
+    if (chunk->cardinality == 0)
+        _chunks.erase(_chunks.begin() + (chunk - _chunks.data()));
+}
+
+
+void IndexRangeSet::remove(const IndexRange& range)
+{
+    updateChunks(_chunks, IndexRangeList::validate(range), false);
+}
+
+
+void IndexRangeSet::clear()
+{
+    _chunks.clear();
+}
+
+
+bool IndexRangeSet::empty() const
+{
+    return _chunks.empty();
+}
+
+
+std::size_t IndexRangeSet::cardinality() const
+{
+    std::size_t result = 0;
+
+    for (auto& chunk: _chunks)
+        result += chunk.cardinality;
+
+    return result;
+}
+
+
+bool IndexRangeSet::contains(std::size_t index) const
+{
+    const Chunk* chunk = _find(index >> CHUNK_BITS);
+
+    if (chunk == nullptr)
+        return false;
+
+    std::size_t value = index & (CHUNK_SIZE - 1);
+
+    switch (chunk->type)
+    {
+        case Type::ARRAY:
+            return std::binary_search(chunk->array.begin(), chunk->array.end(), uint16_t(value));
+        case Type::BITMAP:
+            return testBit(chunk->bitmap, value);
+        case Type::RUN:
+        {
+            auto iter = std::upper_bound(chunk->runs.begin(),
+                                         chunk->runs.end(),
+                                         value,
+                                         [](std::size_t v, const IndexRange& run) {
+                                             return v < run.location;
+                                         });
+
+            return iter != chunk->runs.begin() && (iter - 1)->contains(value);
+        }
+    }
+
+    return false;
+}
+
+
+void IndexRangeSet::optimize()
+{
+    for (auto& chunk: _chunks)
+        ofx::optimize(chunk);
+}
+
+
+std::size_t IndexRangeSet::sizeInBytes() const
+{
+    std::size_t result = 0;
+
+    for (auto& chunk: _chunks)
+        result += sizeof(Chunk) + bytesFor(chunk.type, chunk.cardinality, chunk.runs.size());
+
+    return result;
+}
+
+
+const std::vector<IndexRangeSet::Chunk>& IndexRangeSet::chunks() const
+{
+    return _chunks;
+}
+
+
+IndexRangeSet IndexRangeSet::unionWith(const IndexRangeSet& other) const
+{
+    IndexRangeSet result;
+    result._chunks = combineChunkLists(_chunks, other._chunks, Operation::UNION);
+    return result;
+}
+
+
+IndexRangeSet IndexRangeSet::intersectionWith(const IndexRangeSet& other) const
+{
+    IndexRangeSet result;
+    result._chunks = combineChunkLists(_chunks, other._chunks, Operation::INTERSECTION);
+    return result;
+}
+
+
+IndexRangeSet IndexRangeSet::differenceWith(const IndexRangeSet& other) const
+{
+    IndexRangeSet result;
+    result._chunks = combineChunkLists(_chunks, other._chunks, Operation::DIFFERENCE);
+    return result;
+}
+
+
+bool IndexRangeSet::operator == (const IndexRangeSet& other) const
+{
+    if (_chunks.size() != other._chunks.size())
+        return false;
+
+    for (std::size_t i = 0; i < _chunks.size(); ++i)
+    {
+        const Chunk& a = _chunks[i];
+        const Chunk& b = other._chunks[i];
+
+        if (a.key != b.key || a.cardinality != b.cardinality)
+            return false;
+
+        if (a.type == b.type)
+        {
+            if (a.array != b.array || a.bitmap != b.bitmap || a.runs != b.runs)
+                return false;
+        }
+        else if (convertedCopy(a, Type::RUN).runs != convertedCopy(b, Type::RUN).runs)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool IndexRangeSet::operator != (const IndexRangeSet& other) const
+{
+    return !(*this == other);
+}
+
+
+IndexRangeList IndexRangeSet::toList() const
+{
+    IndexRangeList result;
+
+    // Chunks are sorted, so each add() takes the append fast path.
+    for (auto& chunk: _chunks)
+    {
+        std::size_t base = chunk.key << CHUNK_BITS;
+
+        forEachRun(chunk, [&](std::size_t first, std::size_t last) {
+            result.add(IndexRange::fromExclusiveInterval(base + first, base + last));
+        });
+    }
+
+    return result;
+}
+
+
+IndexRangeSet::Chunk* IndexRangeSet::_find(std::size_t key)
+{
+    return const_cast<Chunk*>(static_cast<const IndexRangeSet*>(this)->_find(key));
+}
+
+
+const IndexRangeSet::Chunk* IndexRangeSet::_find(std::size_t key) const
+{
+    auto iter = std::lower_bound(_chunks.begin(),
+                                 _chunks.end(),
+                                 key,
+                                 [](const Chunk& chunk, std::size_t k) {
+                                     return chunk.key < k;
+                                 });
+
+    if (iter == _chunks.end() || iter->key != key)
+        return nullptr;
+
+    return &(*iter);
+}
+
+
+} // namespace ofx
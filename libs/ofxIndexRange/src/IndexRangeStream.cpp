@@ -0,0 +1,259 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/IndexRangeStream.h"
+#include "ofx/IndexRangeList.h"
+
+
+namespace ofx {
+
+
+IndexRangeStream::IndexRangeStream(): IndexRangeStream(0)
+{
+}
+
+
+IndexRangeStream::IndexRangeStream(std::size_t watermark):
+    _watermark(watermark)
+{
+}
+
+
+void IndexRangeStream::add(const IndexRange& _range)
+{
+    IndexRange range = IndexRangeList::validate(_range);
+
+    if (range.getMax() <= _watermark)
+        return;
+
+    if (range.location < _watermark)
+        range.setMin(_watermark);
+
+    if (range.empty())
+        return;
+
+    // Appending in order.
+    if (_size == 0 || range.location >= _at(_size - 1).location)
+    {
+        if (_size != 0 && _at(_size - 1).getMax() >= range.location)
+        {
+            IndexRange& back = _at(_size - 1);
+
+            if (range.getMax() > back.getMax())
+            {
+                _cardinality += range.getMax() - back.getMax();
+                back.setMax(range.getMax());
+            }
+        }
+        else
+        {
+            _insert(_size, range);
+            _cardinality += range.size;
+        }
+
+        return;
+    }
+
+    // Find the first range that ends at or after the new range starts.
+    std::size_t lo = 0;
+    std::size_t count = _size;
+
+    while (count > 0)
+    {
+        std::size_t step = count / 2;
+
+        if (_at(lo + step).getMax() < range.location)
+        {
+            lo += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    // Merge with every range it overlaps or is adjacent to.
+    std::size_t hi = lo;
+    IndexRange merged = range;
+
+    while (hi < _size && _at(hi).location <= range.getMax())
+    {
+        _cardinality -= _at(hi).size;
+        merged = merged.unionWith(_at(hi));
+        ++hi;
+    }
+
+    _cardinality += merged.size;
+
+    if (lo == hi)
+    {
+        _insert(lo, merged);
+    }
+    else
+    {
+        _at(lo) = merged;
+        _erase(lo + 1, hi);
+    }
+}
+
+
+void IndexRangeStream::advanceWatermark(std::size_t watermark)
+{
+    if (watermark <= _watermark)
+        return;
+
+    _watermark = watermark;
+
+    while (_size > 0 && _at(0).getMax() <= _watermark)
+    {
+        _cardinality -= _at(0).size;
+        _head = (_head + 1) & (_buffer.size() - 1);
+        --_size;
+    }
+
+    if (_size > 0 && _at(0).location < _watermark)
+    {
+        _cardinality -= _watermark - _at(0).location;
+        _at(0).setMin(_watermark);
+    }
+}
+
+
+std::size_t IndexRangeStream::watermark() const
+{
+    return _watermark;
+}
+
+
+std::size_t IndexRangeStream::contiguousPrefixEnd() const
+{
+    if (_size > 0 && (*this)[0].location == _watermark)
+        return (*this)[0].getMax();
+
+    return _watermark;
+}
+
+
+void IndexRangeStream::clear()
+{
+    _head = 0;
+    _size = 0;
+    _cardinality = 0;
+}
+
+
+bool IndexRangeStream::empty() const
+{
+    return _size == 0;
+}
+
+
+std::size_t IndexRangeStream::size() const
+{
+    return _size;
+}
+
+
+std::size_t IndexRangeStream::cardinality() const
+{
+    return _cardinality;
+}
+
+
+const IndexRange& IndexRangeStream::operator [] (std::size_t i) const
+{
+    return _buffer[(_head + i) & (_buffer.size() - 1)];
+}
+
+
+std::vector<IndexRange> IndexRangeStream::ranges() const
+{
+    std::vector<IndexRange> results;
+    results.reserve(_size);
+
+    for (std::size_t i = 0; i < _size; ++i)
+        results.push_back((*this)[i]);
+
+    return results;
+}
+
+
+IndexRange& IndexRangeStream::_at(std::size_t i)
+{
+    return _buffer[(_head + i) & (_buffer.size() - 1)];
+}
+
+
+void IndexRangeStream::_grow()
+{
+    std::vector<IndexRange> buffer(std::max(std::size_t(8), _buffer.size() * 2));
+
+    for (std::size_t i = 0; i < _size; ++i)
+        buffer[i] = _at(i);
+
+    _buffer.swap(buffer);
+    _head = 0;
+}
+
+
+void IndexRangeStream::_insert(std::size_t i, const IndexRange& range)
+{
+    if (_size == _buffer.size())
+        _grow();
+
+    std::size_t mask = _buffer.size() - 1;
+
+    if (i < _size - i)
+    {
+        // Shift the leading ranges down by one.
+        _head = (_head + mask) & mask;
+
+        for (std::size_t j = 0; j < i; ++j)
+            _at(j) = _at(j + 1);
+    }
+    else
+    {
+        // Shift the trailing ranges up by one.
+        for (std::size_t j = _size; j > i; --j)
+            _at(j) = _at(j - 1);
+    }
+
+    _at(i) = range;
+    ++_size;
+}
+
+
+void IndexRangeStream::_erase(std::size_t first, std::size_t last)
+{
+    std::size_t count = last - first;
+
+    if (count == 0)
+        return;
+
+    std::size_t mask = _buffer.size() - 1;
+
+    if (first < _size - last)
+    {
+        // Shift the leading ranges up.
+        for (std::size_t j = first; j > 0; --j)
+            _at(j - 1 + count) = _at(j - 1);
+
+        _head = (_head + count) & mask;
+    }
+    else
+    {
+        // Shift the trailing ranges down.
+        for (std::size_t j = last; j < _size; ++j)
+            _at(j - count) = _at(j);
+    }
+
+    _size -= count;
+}
+
+
+} // namespace ofx
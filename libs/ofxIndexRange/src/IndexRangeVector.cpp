@@ -0,0 +1,343 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/IndexRangeVector.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+
+namespace ofx {
+
+
+const std::size_t IndexRangeVector::INLINE_CAPACITY;
+
+
+IndexRangeVector::IndexRangeVector():
+    _data(reinterpret_cast<IndexRange*>(_buffer))
+{
+}
+
+
+IndexRangeVector::IndexRangeVector(const_iterator first, const_iterator last):
+    IndexRangeVector()
+{
+    std::size_t count = last - first;
+    reserve(count);
+    if (count > 0)
+        std::memcpy(_data, first, count * sizeof(IndexRange));
+    _size = count;
+}
+
+
+IndexRangeVector::IndexRangeVector(const IndexRangeVector& other):
+    IndexRangeVector(other.begin(), other.end())
+{
+}
+
+
+IndexRangeVector::IndexRangeVector(IndexRangeVector&& other) noexcept:
+    IndexRangeVector()
+{
+    swap(other);
+}
+
+
+IndexRangeVector::~IndexRangeVector()
+{
+    _release();
+}
+
+
+IndexRangeVector& IndexRangeVector::operator = (const IndexRangeVector& other)
+{
+    if (this != &other)
+    {
+        _size = 0;
+        reserve(other._size);
+        if (other._size > 0)
+            std::memcpy(_data, other._data, other._size * sizeof(IndexRange));
+        _size = other._size;
+    }
+
+    return *this;
+}
+
+
+IndexRangeVector& IndexRangeVector::operator = (IndexRangeVector&& other) noexcept
+{
+    if (this != &other)
+    {
+        _release();
+        _size = 0;
+        swap(other);
+    }
+
+    return *this;
+}
+
+
+IndexRangeVector::iterator IndexRangeVector::begin()
+{
+    return _data;
+}
+
+
+IndexRangeVector::iterator IndexRangeVector::end()
+{
+    return _data + _size;
+}
+
+
+IndexRangeVector::const_iterator IndexRangeVector::begin() const
+{
+    return _data;
+}
+
+
+IndexRangeVector::const_iterator IndexRangeVector::end() const
+{
+    return _data + _size;
+}
+
+
+IndexRange* IndexRangeVector::data()
+{
+    return _data;
+}
+
+
+const IndexRange* IndexRangeVector::data() const
+{
+    return _data;
+}
+
+
+IndexRange& IndexRangeVector::operator [] (std::size_t i)
+{
+    return _data[i];
+}
+
+
+const IndexRange& IndexRangeVector::operator [] (std::size_t i) const
+{
+    return _data[i];
+}
+
+
+IndexRange& IndexRangeVector::front()
+{
+    return _data[0];
+}
+
+
+const IndexRange& IndexRangeVector::front() const
+{
+    return _data[0];
+}
+
+
+IndexRange& IndexRangeVector::back()
+{
+    return _data[_size - 1];
+}
+
+
+const IndexRange& IndexRangeVector::back() const
+{
+    return _data[_size - 1];
+}
+
+
+bool IndexRangeVector::empty() const
+{
+    return 0 == _size;
+}
+
+
+std::size_t IndexRangeVector::size() const
+{
+    return _size;
+}
+
+
+std::size_t IndexRangeVector::capacity() const
+{
+    return _capacity;
+}
+
+
+bool IndexRangeVector::isInline() const
+{
+    return _data == reinterpret_cast<const IndexRange*>(_buffer);
+}
+
+
+void IndexRangeVector::reserve(std::size_t count)
+{
+    if (count > _capacity)
+        _grow(count);
+}
+
+
+void IndexRangeVector::resize(std::size_t count)
+{
+    reserve(count);
+
+    for (std::size_t i = _size; i < count; ++i)
+        new (_data + i) IndexRange();
+
+    _size = count;
+}
+
+
+void IndexRangeVector::clear()
+{
+    _size = 0;
+}
+
+
+void IndexRangeVector::push_back(const IndexRange& range)
+{
+    if (_size == _capacity)
+    {
+        // The range may live in our own storage, so copy it before growing.
+        IndexRange copy = range;
+        _grow(_size + 1);
+        _data[_size++] = copy;
+    }
+    else
+    {
+        _data[_size++] = range;
+    }
+}
+
+
+void IndexRangeVector::pop_back()
+{
+    --_size;
+}
+
+
+IndexRangeVector::iterator IndexRangeVector::insert(iterator position,
+                                                    const IndexRange& range)
+{
+    std::size_t offset = position - _data;
+    IndexRange copy = range;
+
+    if (_size == _capacity)
+        _grow(_size + 1);
+
+    std::memmove(_data + offset + 1,
+                 _data + offset,
+                 (_size - offset) * sizeof(IndexRange));
+    _data[offset] = copy;
+    ++_size;
+
+    return _data + offset;
+}
+
+
+IndexRangeVector::iterator IndexRangeVector::erase(iterator position)
+{
+    return erase(position, position + 1);
+}
+
+
+IndexRangeVector::iterator IndexRangeVector::erase(iterator first,
+                                                   iterator last)
+{
+    if (first != last)
+    {
+        std::memmove(first, last, (end() - last) * sizeof(IndexRange));
+        _size -= (last - first);
+    }
+
+    return first;
+}
+
+
+void IndexRangeVector::swap(IndexRangeVector& other) noexcept
+{
+    if (isInline() || other.isInline())
+    {
+        // At least one side must be copied through the inline buffers.
+        IndexRangeVector* a = this;
+        IndexRangeVector* b = &other;
+
+        if (!a->isInline())
+            std::swap(a, b);
+
+        // a is inline, b may be either.
+        unsigned char buffer[INLINE_CAPACITY * sizeof(IndexRange)];
+        std::size_t aSize = a->_size;
+        std::memcpy(buffer, a->_buffer, aSize * sizeof(IndexRange));
+
+        if (b->isInline())
+        {
+            std::memcpy(a->_buffer, b->_buffer, b->_size * sizeof(IndexRange));
+        }
+        else
+        {
+            a->_data = b->_data;
+            a->_capacity = b->_capacity;
+            b->_data = reinterpret_cast<IndexRange*>(b->_buffer);
+            b->_capacity = INLINE_CAPACITY;
+        }
+
+        std::memcpy(b->_buffer, buffer, aSize * sizeof(IndexRange));
+        a->_size = b->_size;
+        b->_size = aSize;
+    }
+    else
+    {
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+        std::swap(_capacity, other._capacity);
+    }
+}
+
+
+void IndexRangeVector::_grow(std::size_t count)
+{
+    std::size_t capacity = std::max(count, _capacity * 2);
+    std::size_t bytes = capacity * sizeof(IndexRange);
+
+    IndexRange* data = nullptr;
+
+    if (isInline())
+    {
+        data = static_cast<IndexRange*>(std::malloc(bytes));
+        if (data != nullptr && _size > 0)
+            std::memcpy(data, _data, _size * sizeof(IndexRange));
+    }
+    else
+    {
+        data = static_cast<IndexRange*>(std::realloc(_data, bytes));
+    }
+
+    if (data == nullptr)
+        throw std::bad_alloc();
+
+    _data = data;
+    _capacity = capacity;
+}
+
+
+void IndexRangeVector::_release()
+{
+    if (!isInline())
+    {
+        std::free(_data);
+        _data = reinterpret_cast<IndexRange*>(_buffer);
+        _capacity = INLINE_CAPACITY;
+    }
+}
+
+
+} // namespace ofx
@@ -0,0 +1,563 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofx/PersistentIndexRangeList.h"
+#include <atomic>
+#include <cstdint>
+
+
+namespace ofx {
+
+
+/// \brief An immutable treap node.
+///
+/// A node's true location is its stored location plus the shifts of the node
+/// and all of its ancestors. Shifts let insert() and erase() move every range
+/// after a position by copying a single node.
+struct PersistentIndexRangeList::Node
+{
+    /// \brief The range, not including shifts.
+    IndexRange range;
+
+    /// \brief The heap priority.
+    uint64_t priority = 0;
+
+    /// \brief The shift applied to this node and all of its descendants.
+    ///
+    /// Shifts are added modulo 2^64, so erase() shifts down by adding the
+    /// two's complement of the erased size. Every true location is in
+    /// [0, IndexRange::MAX], so the wrapped sums along a path are exact.
+    std::size_t shift = 0;
+
+    /// \brief The number of ranges in this subtree.
+    std::size_t count = 0;
+
+    /// \brief The number of indices covered in this subtree.
+    std::size_t cardinality = 0;
+
+    std::shared_ptr<const Node> left;
+    std::shared_ptr<const Node> right;
+
+};
+
+
+/// \brief Tree operations. Every operation returns new nodes and never
+/// modifies an existing node.
+struct PersistentIndexRangeList::Tree
+{
+    typedef std::shared_ptr<const Node> Ptr;
+
+    static uint64_t nextPriority()
+    {
+        // SplitMix64 of a counter.
+        static std::atomic<uint64_t> counter(0);
+        uint64_t z = (counter += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    static Ptr make(const IndexRange& range,
+                    uint64_t priority,
+                    std::size_t shift,
+                    const Ptr& left,
+                    const Ptr& right)
+    {
+        auto node = std::make_shared<Node>();
+        node->range = range;
+        node->priority = priority;
+        node->shift = shift;
+        node->left = left;
+        node->right = right;
+        node->count = 1 + count(left) + count(right);
+        node->cardinality = range.size + cardinality(left) + cardinality(right);
+        return node;
+    }
+
+    static Ptr single(const IndexRange& range)
+    {
+        return make(range, nextPriority(), 0, nullptr, nullptr);
+    }
+
+    static std::size_t count(const Ptr& t)
+    {
+        return t ? t->count : 0;
+    }
+
+    static std::size_t cardinality(const Ptr& t)
+    {
+        return t ? t->cardinality : 0;
+    }
+
+    /// \returns \p t with every range shifted by \p shift.
+    static Ptr shifted(const Ptr& t, std::size_t shift)
+    {
+        if (!t || shift == 0)
+            return t;
+
+        return make(t->range, t->priority, t->shift + shift, t->left, t->right);
+    }
+
+    /// \returns \p t with its shift moved to its children.
+    static Ptr push(const Ptr& t)
+    {
+        if (!t || t->shift == 0)
+            return t;
+
+        IndexRange range = t->range;
+        range.location += t->shift;
+
+        return make(range,
+                    t->priority,
+                    0,
+                    shifted(t->left, t->shift),
+                    shifted(t->right, t->shift));
+    }
+
+    /// \brief Concatenate two trees where every range of a is before b.
+    static Ptr merge(const Ptr& _a, const Ptr& _b)
+    {
+        if (!_a)
+            return _b;
+
+        if (!_b)
+            return _a;
+
+        if (_a->priority > _b->priority)
+        {
+            Ptr a = push(_a);
+            return make(a->range, a->priority, 0, a->left, merge(a->right, _b));
+        }
+
+        Ptr b = push(_b);
+        return make(b->range, b->priority, 0, merge(_a, b->left), b->right);
+    }
+
+    /// \brief Split a tree into the ranges for which \p isLeft is true and
+    /// the rest. \p isLeft must be true for a prefix of the ranges.
+    template <typename Predicate>
+    static void split(const Ptr& _t, Predicate isLeft, Ptr& left, Ptr& right)
+    {
+        if (!_t)
+        {
+            left = nullptr;
+            right = nullptr;
+            return;
+        }
+
+        Ptr t = push(_t);
+        Ptr middle;
+
+        if (isLeft(t->range))
+        {
+            split(t->right, isLeft, middle, right);
+            left = make(t->range, t->priority, 0, t->left, middle);
+        }
+        else
+        {
+            split(t->left, isLeft, left, middle);
+            right = make(t->range, t->priority, 0, middle, t->right);
+        }
+    }
+
+    /// \returns the first range of a non-empty tree.
+    static IndexRange front(const Ptr& t)
+    {
+        std::size_t shift = 0;
+        const Node* node = t.get();
+
+        for (; node->left; node = node->left.get())
+            shift += node->shift;
+
+        IndexRange range = node->range;
+        range.location += shift + node->shift;
+        return range;
+    }
+
+    /// \returns the last range of a non-empty tree.
+    static IndexRange back(const Ptr& t)
+    {
+        std::size_t shift = 0;
+        const Node* node = t.get();
+
+        for (; node->right; node = node->right.get())
+            shift += node->shift;
+
+        IndexRange range = node->range;
+        range.location += shift + node->shift;
+        return range;
+    }
+
+    /// \brief Remove the first range of a non-empty tree.
+    static Ptr popFront(const Ptr& t)
+    {
+        std::size_t location = front(t).location;
+        Ptr left, right;
+        split(t, [&](const IndexRange& r) { return r.location <= location; }, left, right);
+        return right;
+    }
+
+    /// \brief Remove the last range of a non-empty tree.
+    static Ptr popBack(const Ptr& t)
+    {
+        std::size_t location = back(t).location;
+        Ptr left, right;
+        split(t, [&](const IndexRange& r) { return r.location < location; }, left, right);
+        return left;
+    }
+
+    /// \brief Concatenate left, the sorted ranges and right, merging any
+    /// ranges that touch at the seams.
+    static Ptr join(Ptr left, std::vector<IndexRange> middle, Ptr right)
+    {
+        if (left && (!middle.empty() || right))
+        {
+            IndexRange last = back(left);
+            IndexRange next = middle.empty() ? front(right) : middle.front();
+
+            if (last.getMax() >= next.location)
+            {
+                left = popBack(left);
+                middle.insert(middle.begin(), last);
+            }
+        }
+
+        if (right && !middle.empty())
+        {
+            IndexRange first = front(right);
+
+            if (middle.back().getMax() >= first.location)
+            {
+                right = popFront(right);
+                middle.push_back(first);
+            }
+        }
+
+        Ptr result = left;
+        IndexRange current;
+
+        for (auto& range: middle)
+        {
+            if (range.empty())
+                continue;
+
+            if (!current.empty() && current.getMax() >= range.location)
+            {
+                current = current.unionWith(range);
+            }
+            else
+            {
+                if (!current.empty())
+                    result = merge(result, single(current));
+
+                current = range;
+            }
+        }
+
+        if (!current.empty())
+            result = merge(result, single(current));
+
+        return merge(result, right);
+    }
+
+    static void collect(const Node* node,
+                        std::size_t shift,
+                        std::vector<IndexRange>& results)
+    {
+        if (!node)
+            return;
+
+        shift += node->shift;
+        collect(node->left.get(), shift, results);
+        IndexRange range = node->range;
+        range.location += shift;
+        results.push_back(range);
+        collect(node->right.get(), shift, results);
+    }
+
+};
+
+
+PersistentIndexRangeList::PersistentIndexRangeList()
+{
+}
+
+
+PersistentIndexRangeList::PersistentIndexRangeList(const IndexRangeList& list)
+{
+    for (auto& range: list.ranges())
+        _root = Tree::merge(_root, Tree::single(range));
+}
+
+
+void PersistentIndexRangeList::add(const IndexRange& _range)
+{
+    IndexRange range = IndexRangeList::validate(_range);
+
+    if (range.empty())
+        return;
+
+    Tree::Ptr left, rest, middle, right;
+
+    // Ranges strictly before, touching and strictly after the range.
+    Tree::split(_root, [&](const IndexRange& r) { return r.getMax() < range.location; }, left, rest);
+    Tree::split(rest, [&](const IndexRange& r) { return r.location <= range.getMax(); }, middle, right);
+
+    if (middle)
+        range = range.unionWith(Tree::front(middle)).unionWith(Tree::back(middle));
+
+    _root = Tree::merge(Tree::merge(left, Tree::single(range)), right);
+}
+
+
+void PersistentIndexRangeList::remove(const IndexRange& _range)
+{
+    IndexRange range = IndexRangeList::validate(_range);
+
+    if (range.empty())
+        return;
+
+    Tree::Ptr left, rest, middle, right;
+
+    // Ranges before, intersecting and after the range.
+    Tree::split(_root, [&](const IndexRange& r) { return r.getMax() <= range.location; }, left, rest);
+    Tree::split(rest, [&](const IndexRange& r) { return r.location < range.getMax(); }, middle, right);
+
+    if (middle)
+    {
+        IndexRange first = Tree::front(middle);
+        IndexRange last = Tree::back(middle);
+
+        if (first.location < range.location)
+            left = Tree::merge(left, Tree::single(IndexRange::fromExclusiveInterval(first.location, range.location)));
+
+        if (last.getMax() > range.getMax())
+            right = Tree::merge(Tree::single(IndexRange::fromExclusiveInterval(range.getMax(), last.getMax())), right);
+    }
+
+    _root = Tree::merge(left, right);
+}
+
+
+void PersistentIndexRangeList::insert(const IndexRange& _range)
+{
+    IndexRange range = IndexRangeList::validate(_range);
+
+    if (range.empty())
+        return;
+
+    std::size_t position = range.location;
+    std::size_t shift = range.size;
+
+    Tree::Ptr left, right, dropped;
+
+    // Ranges starting at or before the position keep their location.
+    Tree::split(_root, [&](const IndexRange& r) { return r.location <= position; }, left, right);
+
+    // A range containing the position is expanded.
+    if (left && Tree::back(left).getMax() > position)
+    {
+        IndexRange last = Tree::back(left);
+        std::size_t max = last.getMax() + shift;
+        last.setMax(max < last.getMax() ? IndexRange::MAX : max);
+        left = Tree::merge(Tree::popBack(left), Tree::single(last));
+    }
+
+    // Ranges whose location would overflow are removed.
+    Tree::split(right, [&](const IndexRange& r) { return r.location <= IndexRange::MAX - shift; }, right, dropped);
+
+    // The last range may be truncated.
+    std::vector<IndexRange> truncated;
+
+    if (right && Tree::back(right).getMax() > IndexRange::MAX - shift)
+    {
+        IndexRange last = Tree::back(right);
+        right = Tree::popBack(right);
+        truncated.push_back(IndexRange::fromExclusiveInterval(last.location + shift, IndexRange::MAX));
+    }
+
+    _root = Tree::join(Tree::merge(left, Tree::shifted(right, shift)), truncated, nullptr);
+}
+
+
+void PersistentIndexRangeList::erase(const IndexRange& _range)
+{
+    IndexRange range = IndexRangeList::validate(_range);
+
+    if (range.empty())
+        return;
+
+    std::size_t min = range.getMin();
+    std::size_t max = range.getMax();
+
+    // Map an index through the erase.
+    auto map = [&](std::size_t i) {
+        if (i <= min)
+            return i;
+        else if (i <= max)
+            return min;
+        return i - range.size;
+    };
+
+    Tree::Ptr left, rest, middle, right;
+
+    // Ranges before, intersecting and after the erased section.
+    Tree::split(_root, [&](const IndexRange& r) { return r.getMax() <= min; }, left, rest);
+    Tree::split(rest, [&](const IndexRange& r) { return r.location < max; }, middle, right);
+
+    // Only the first and last intersecting ranges can survive.
+    std::vector<IndexRange> pieces;
+
+    if (middle)
+    {
+        IndexRange first = Tree::front(middle);
+        IndexRange last = Tree::back(middle);
+
+        pieces.push_back(IndexRange::fromExclusiveInterval(map(first.location), map(first.getMax())));
+
+        if (Tree::count(middle) > 1)
+            pieces.push_back(IndexRange::fromExclusiveInterval(map(last.location), map(last.getMax())));
+    }
+
+    // Shift the ranges after the erased section down by range.size. This
+    // relies on unsigned wraparound, see Node::shift.
+    _root = Tree::join(left, pieces, Tree::shifted(right, std::size_t(0) - range.size));
+}
+
+
+void PersistentIndexRangeList::clear()
+{
+    _root = nullptr;
+}
+
+
+bool PersistentIndexRangeList::empty() const
+{
+    return !_root;
+}
+
+
+std::size_t PersistentIndexRangeList::size() const
+{
+    return Tree::count(_root);
+}
+
+
+std::size_t PersistentIndexRangeList::cardinality() const
+{
+    return Tree::cardinality(_root);
+}
+
+
+bool PersistentIndexRangeList::contains(std::size_t index) const
+{
+    std::size_t shift = 0;
+    const Node* node = _root.get();
+
+    while (node)
+    {
+        shift += node->shift;
+        std::size_t location = node->range.location + shift;
+
+        if (index < location)
+            node = node->left.get();
+        else if (index - location < node->range.size)
+            return true;
+        else
+            node = node->right.get();
+    }
+
+    return false;
+}
+
+
+std::vector<IndexRange> PersistentIndexRangeList::ranges() const
+{
+    std::vector<IndexRange> results;
+    results.reserve(size());
+    Tree::collect(_root.get(), 0, results);
+    return results;
+}
+
+
+IndexRangeList PersistentIndexRangeList::toList() const
+{
+    return IndexRangeList(ranges());
+}
+
+
+bool PersistentIndexRangeList::isSameVersion(const PersistentIndexRangeList& other) const
+{
+    return _root == other._root;
+}
+
+
+IndexRangeListHistory::IndexRangeListHistory():
+    IndexRangeListHistory(PersistentIndexRangeList())
+{
+}
+
+
+IndexRangeListHistory::IndexRangeListHistory(const PersistentIndexRangeList& initial):
+    _versions(1, initial)
+{
+}
+
+
+const PersistentIndexRangeList& IndexRangeListHistory::current() const
+{
+    return _versions[_current];
+}
+
+
+void IndexRangeListHistory::commit(const PersistentIndexRangeList& version)
+{
+    _versions.resize(_current + 1);
+    _versions.push_back(version);
+    ++_current;
+}
+
+
+bool IndexRangeListHistory::canUndo() const
+{
+    return _current > 0;
+}
+
+
+bool IndexRangeListHistory::canRedo() const
+{
+    return _current + 1 < _versions.size();
+}
+
+
+bool IndexRangeListHistory::undo()
+{
+    if (!canUndo())
+        return false;
+
+    --_current;
+    return true;
+}
+
+
+bool IndexRangeListHistory::redo()
+{
+    if (!canRedo())
+        return false;
+
+    ++_current;
+    return true;
+}
+
+
+std::size_t IndexRangeListHistory::size() const
+{
+    return _versions.size();
+}
+
+
+} // namespace ofx
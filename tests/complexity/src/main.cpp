@@ -0,0 +1,399 @@
+//
+// Copyright (c) 2019 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:    MIT
+//
+
+
+#include "ofMain.h"
+#include "ofAppNoWindow.h"
+#include "ofxUnitTests.h"
+#include "ofx/IndexRangeList.h"
+#include "ofx/IndexRangeMapper.h"
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+
+
+/// \brief Checks the empirical scaling of IndexRangeList operations.
+///
+/// Each operation is timed across geometrically growing sizes and input
+/// shapes. The exponent k of time ~ n^k is fit by least squares in log-log
+/// space and must not exceed the documented complexity by more than
+/// TOLERANCE. An accidentally quadratic path fits an exponent near 2.
+///
+/// A bitset oracle runs random edits alongside the lists, so the optimized
+/// paths are also checked for correctness.
+class ofApp: public ofxUnitTestsApp
+{
+    using Range = ofx::IndexRange;
+    using RangeList = ofx::IndexRangeList;
+
+    /// \brief The shape of generated ranges.
+    enum class Shape
+    {
+        /// \brief Ranges in increasing order with gaps.
+        SEQUENTIAL,
+        /// \brief Ranges at random locations.
+        RANDOM,
+        /// \brief Ranges in decreasing order with gaps.
+        REVERSED,
+        /// \brief Small ranges in a few dense clusters, many overlapping.
+        CLUSTERED
+    };
+
+    /// \brief The smallest number of ranges timed.
+    static const std::size_t MIN_SIZE = 1 << 10;
+
+    /// \brief The largest number of ranges timed.
+    static const std::size_t MAX_SIZE = 1 << 16;
+
+    /// \brief The number of timings per size, of which the fastest is kept.
+    static const std::size_t NUM_TRIALS = 3;
+
+    /// \brief The allowed excess over the documented exponent.
+    static constexpr double TOLERANCE = 0.4;
+
+    /// \brief The number of bits tracked by the oracle.
+    static const std::size_t ORACLE_BITS = 1 << 12;
+
+    std::mt19937_64 rng;
+
+    void run() override
+    {
+        const std::vector<Shape> shapes = {
+            Shape::SEQUENTIAL,
+            Shape::RANDOM,
+            Shape::REVERSED,
+            Shape::CLUSTERED
+        };
+
+        for (auto shape: shapes)
+        {
+            std::string name = shapeName(shape);
+
+            checkExponent("IndexRangeList::add() " + name, 1, [&](std::size_t n) {
+                auto ranges = makeRanges(shape, n);
+                return time([&]() {
+                    RangeList list;
+                    for (auto& range: ranges)
+                        list.add(range);
+                    return list.size();
+                });
+            });
+
+            checkExponent("IndexRangeList::unionWith() " + name, 1, [&](std::size_t n) {
+                RangeList a = makeList(shape, n);
+                RangeList b = makeList(Shape::RANDOM, n);
+                return time([&]() {
+                    return a.unionWith(b).size()
+                         + a.intersectionWith(b).size()
+                         + a.differenceWith(b).size();
+                });
+            });
+
+            checkExponent("IndexRangeList::remove() " + name, 1, [&](std::size_t n) {
+                RangeList list = makeList(shape, n);
+                Range last = list.back();
+                Range middle = Range::fromExclusiveInterval(last.getMax() / 4, last.getMax() / 4 * 3);
+                return time([&]() {
+                    RangeList copy = list;
+                    copy.remove(middle);
+                    return copy.size();
+                });
+            });
+        }
+
+        // Appending to a new list keeps the fingerprint up to date.
+        checkExponent("IndexRangeList::add() hash() append", 1, [&](std::size_t n) {
+            return time([&]() {
+                RangeList list;
+                uint64_t hash = 0;
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    list.add({ i * 10, 5 });
+                    hash += list.hash();
+                }
+                return std::size_t(hash);
+            });
+        });
+
+        // Each removal splits a range, which must not sort the list again.
+        checkExponent("IndexRangeList::remove() split", 1, [&](std::size_t n) {
+            RangeList list;
+            for (std::size_t i = 0; i < n; ++i)
+                list.add({ i * 100, 50 });
+
+            return time([&]() {
+                RangeList copy = list;
+                for (std::size_t i = 0; i < 64; ++i)
+                {
+                    copy.remove({ (i * 7919 % n) * 100 + 10, 10 });
+                    copy.contains(0);
+                }
+                return copy.size();
+            });
+        });
+
+        checkExponent("IndexRangeList::insert()", 1, [&](std::size_t n) {
+            RangeList list = makeList(Shape::SEQUENTIAL, n);
+            return time([&]() {
+                RangeList copy = list;
+                copy.insert({ 0, 10 });
+                copy.erase({ 0, 10 });
+                return copy.size();
+            });
+        });
+
+        checkExponent("IndexRangeList::contains()", 0, [&](std::size_t n) {
+            RangeList list = makeList(Shape::RANDOM, n);
+            std::size_t max = list.back().getMax();
+            return time([&]() {
+                std::size_t count = 0;
+                for (std::size_t i = 0; i < 1024; ++i)
+                    count += list.contains(i * 7919 % max);
+                return count;
+            });
+        });
+
+        checkExponent("IndexRangeList::rank()", 0, [&](std::size_t n) {
+            RangeList list = makeList(Shape::RANDOM, n);
+            std::size_t max = list.back().getMax();
+            std::size_t cardinality = list.cardinality();
+            return time([&]() {
+                std::size_t count = 0;
+                for (std::size_t i = 0; i < 1024; ++i)
+                    count += list.rank(i * 7919 % max) + list.select(i * 7919 % cardinality);
+                return count;
+            });
+        });
+
+        checkExponent("IndexRangeMapper::insert() erase()", 1, [&](std::size_t n) {
+            auto ranges = makeRanges(Shape::RANDOM, n);
+            return time([&]() {
+                ofx::IndexRangeMapper mapper;
+                for (std::size_t i = 0; i < ranges.size(); ++i)
+                {
+                    if (i % 2 == 0)
+                        mapper.insert(ranges[i]);
+                    else
+                        mapper.erase(Range(ranges[i].location, ranges[i].size / 2));
+                }
+                return mapper.size();
+            });
+        });
+
+        for (auto shape: shapes)
+            checkOracle(shape);
+    }
+
+    /// \returns a name for the shape.
+    static std::string shapeName(Shape shape)
+    {
+        switch (shape)
+        {
+            case Shape::SEQUENTIAL: return "sequential";
+            case Shape::RANDOM: return "random";
+            case Shape::REVERSED: return "reversed";
+            case Shape::CLUSTERED: return "clustered";
+        }
+
+        return "";
+    }
+
+    /// \brief Generate ranges of a shape.
+    /// \param shape The shape of the ranges.
+    /// \param n The number of ranges.
+    /// \param scale The spacing between ranges.
+    std::vector<Range> makeRanges(Shape shape, std::size_t n, std::size_t scale = 16)
+    {
+        std::vector<Range> ranges;
+        ranges.reserve(n);
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            std::size_t size = 1 + rng() % (scale / 2);
+
+            switch (shape)
+            {
+                case Shape::SEQUENTIAL:
+                    ranges.push_back(Range(i * scale, size));
+                    break;
+                case Shape::RANDOM:
+                    ranges.push_back(Range(rng() % (n * scale), size));
+                    break;
+                case Shape::REVERSED:
+                    ranges.push_back(Range((n - i) * scale, size));
+                    break;
+                case Shape::CLUSTERED:
+                {
+                    std::size_t cluster = rng() % 8;
+                    ranges.push_back(Range(cluster * n * scale + rng() % (n * 2), size));
+                    break;
+                }
+            }
+        }
+
+        return ranges;
+    }
+
+    /// \brief Generate a list of a shape.
+    RangeList makeList(Shape shape, std::size_t n, std::size_t scale = 16)
+    {
+        RangeList list;
+
+        for (auto& range: makeRanges(shape, n, scale))
+            list.add(range);
+
+        return list;
+    }
+
+    /// \brief Time a function.
+    /// \returns the fastest of NUM_TRIALS runs, in seconds.
+    template <typename Function>
+    static double time(Function function)
+    {
+        double best = std::numeric_limits<double>::max();
+        volatile std::size_t sink = 0;
+
+        for (std::size_t trial = 0; trial < NUM_TRIALS; ++trial)
+        {
+            auto start = std::chrono::steady_clock::now();
+            sink = sink + function();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+
+        return best;
+    }
+
+    /// \brief Fit the exponent k of time ~ n^k.
+    /// \param operation Returns the time taken at size n.
+    /// \returns the fitted exponent.
+    static double fitExponent(const std::function<double(std::size_t)>& operation)
+    {
+        std::vector<double> xs;
+        std::vector<double> ys;
+
+        for (std::size_t n = MIN_SIZE; n <= MAX_SIZE; n *= 4)
+        {
+            xs.push_back(std::log(double(n)));
+            ys.push_back(std::log(std::max(operation(n), 1e-9)));
+        }
+
+        double meanX = std::accumulate(xs.begin(), xs.end(), 0.0) / xs.size();
+        double meanY = std::accumulate(ys.begin(), ys.end(), 0.0) / ys.size();
+        double covariance = 0;
+        double variance = 0;
+
+        for (std::size_t i = 0; i < xs.size(); ++i)
+        {
+            covariance += (xs[i] - meanX) * (ys[i] - meanY);
+            variance += (xs[i] - meanX) * (xs[i] - meanX);
+        }
+
+        return covariance / variance;
+    }
+
+    /// \brief Check that an operation scales no worse than documented.
+    /// \param name The name of the operation.
+    /// \param expected The documented exponent, ignoring log factors.
+    /// \param operation Returns the time taken at size n.
+    void checkExponent(const std::string& name,
+                       double expected,
+                       const std::function<double(std::size_t)>& operation)
+    {
+        double exponent = fitExponent(operation);
+        ofLogNotice("complexity") << name << ": n^" << exponent;
+        ofxTest(exponent <= expected + TOLERANCE, name + " scales as n^" + ofToString(exponent));
+    }
+
+    /// \brief Run random edits on a list and a bitset and compare them.
+    /// \param shape The shape of the ranges used in edits.
+    void checkOracle(Shape shape)
+    {
+        std::string name = "oracle " + shapeName(shape);
+
+        RangeList list;
+        std::vector<bool> bits(ORACLE_BITS, false);
+        bool matches = true;
+
+        for (std::size_t step = 0; step < 2000 && matches; ++step)
+        {
+            auto ranges = makeRanges(shape, 1 + rng() % 4, ORACLE_BITS / 64);
+
+            for (auto& range: ranges)
+            {
+                // Keep edits well inside the oracle.
+                range = Range(range.location % (ORACLE_BITS / 2), range.size);
+
+                switch (rng() % 6)
+                {
+                    case 0:
+                    case 1:
+                        list.add(range);
+                        for (std::size_t i = range.getMin(); i < range.getMax(); ++i)
+                            bits[i] = true;
+                        break;
+                    case 2:
+                        list.remove(range);
+                        for (std::size_t i = range.getMin(); i < range.getMax(); ++i)
+                            bits[i] = false;
+                        break;
+                    case 3:
+                    {
+                        // Indices at or after the location move up, and the
+                        // inserted indices are covered if the location was.
+                        bool covered = bits[range.location];
+                        list.insert(range);
+                        bits.insert(bits.begin() + range.location, range.size, covered);
+                        bits.resize(ORACLE_BITS);
+                        break;
+                    }
+                    case 4:
+                        list.erase(range);
+                        bits.erase(bits.begin() + range.getMin(), bits.begin() + range.getMax());
+                        bits.resize(ORACLE_BITS, false);
+                        break;
+                    case 5:
+                    {
+                        RangeList other;
+                        other.add(range);
+                        list = list.differenceWith(other).unionWith(other.intersectionWith(list));
+                        break;
+                    }
+                }
+
+                // The oracle only tracks ORACLE_BITS indices.
+                list.remove(Range::fromExclusiveInterval(ORACLE_BITS, Range::MAX));
+            }
+
+            std::vector<uint64_t> words = list.toBitset(ORACLE_BITS);
+            std::size_t cardinality = 0;
+
+            for (std::size_t i = 0; i < ORACLE_BITS; ++i)
+            {
+                bool bit = (words[i / 64] >> (i % 64)) & 1;
+                matches = matches && bit == bits[i];
+                cardinality += bits[i];
+            }
+
+            matches = matches && cardinality == list.cardinality();
+        }
+
+        ofxTest(matches, name);
+    }
+
+};
+
+
+int main()
+{
+    ofInit();
+    auto window = make_shared<ofAppNoWindow>();
+    auto app = make_shared<ofApp>();
+    ofRunApp(window, app);
+    return ofRunMainLoop();
+}
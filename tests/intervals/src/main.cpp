@@ -8,8 +8,30 @@
 #include "ofMain.h"
 #include "ofAppNoWindow.h"
 #include "ofxUnitTests.h"
+#include "ofx/CircularIndexRange.h"
+#include "ofx/CircularIndexRangeList.h"
+#include "ofx/CompressedIndexRangeList.h"
 #include "ofx/IndexRange.h"
+#include "ofx/IndexRangeAlgorithms.h"
+#include "ofx/IndexRangeCache.h"
+#include "ofx/IndexRangeDirtyTracker.h"
+#include "ofx/IndexRangeFileReader.h"
+#include "ofx/IndexRangeIntervalTree.h"
 #include "ofx/IndexRangeList.h"
+#include "ofx/IndexRangeListIndex.h"
+#include "ofx/IndexRangeMapper.h"
+#include "ofx/IndexRangeParallel.h"
+#include "ofx/IndexRangeRegion.h"
+#include "ofx/IndexRangeSet.h"
+#include "ofx/IndexRangeStream.h"
+#include "ofx/IndexRangeVector.h"
+#include "ofx/PersistentIndexRangeList.h"
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
 
 
 class ofApp: public ofxUnitTestsApp
@@ -533,6 +555,1052 @@ class ofApp: public ofxUnitTestsApp
                       { { 400, 100 } });
         }
 
+        {
+            ofx::IndexRangeVector ranges;
+            ofxTestEq(ranges.isInline(), true, "IndexRangeVector::isInline()");
+
+            for (std::size_t i = 0; i < ofx::IndexRangeVector::INLINE_CAPACITY; ++i)
+                ranges.push_back(Range(i * 10, 5));
+
+            ofxTestEq(ranges.isInline(), true, "IndexRangeVector::isInline()");
+
+            ranges.push_back(Range(100, 5));
+            ofxTestEq(ranges.isInline(), false, "IndexRangeVector::isInline()");
+            ofxTestEq(ranges.size(), ofx::IndexRangeVector::INLINE_CAPACITY + 1, "IndexRangeVector::size()");
+
+            ranges.insert(ranges.begin(), Range(0, 1));
+            ofxTestEq(ranges.front(), Range(0, 1), "IndexRangeVector::insert()");
+            ranges.erase(ranges.begin());
+            ofxTestEq(ranges.front(), Range(0, 5), "IndexRangeVector::erase()");
+            ofxTestEq(ranges.back(), Range(100, 5), "IndexRangeVector::back()");
+
+            ofx::IndexRangeVector small;
+            small.push_back(Range(1, 1));
+            small.swap(ranges);
+            ofxTestEq(ranges.size(), 1, "IndexRangeVector::swap()");
+            ofxTestEq(ranges.isInline(), true, "IndexRangeVector::swap()");
+            ofxTestEq(small.size(), ofx::IndexRangeVector::INLINE_CAPACITY + 1, "IndexRangeVector::swap()");
+
+            ofx::IndexRangeVector copy = small;
+            ofxTestEq(copy.size(), small.size(), "IndexRangeVector copy");
+            ofxTestEq(copy[2], small[2], "IndexRangeVector copy");
+
+            ofx::IndexRangeVector moved = std::move(copy);
+            ofxTestEq(moved.size(), small.size(), "IndexRangeVector move");
+            ofxTestEq(copy.size(), 0, "IndexRangeVector move");
+        }
+
+        {
+            RangeList list({ { 10, 5 }, { 20, 10 }, { 50, 1 } });
+            ofxTestEq(list.cardinality(), 16, "RangeList::cardinality()");
+            ofxTestEq(list.rank(0), 0, "RangeList::rank()");
+            ofxTestEq(list.rank(12), 2, "RangeList::rank()");
+            ofxTestEq(list.rank(20), 5, "RangeList::rank()");
+            ofxTestEq(list.rank(Range::MAX), 16, "RangeList::rank()");
+            ofxTestEq(list.select(0), 10, "RangeList::select()");
+            ofxTestEq(list.select(5), 20, "RangeList::select()");
+            ofxTestEq(list.select(15), 50, "RangeList::select()");
+            ofxTestEq(list.select(16), Range::MAX, "RangeList::select()");
+
+            list.remove({ 22, 2 });
+            ofxTestEq(list.cardinality(), 14, "RangeList::cardinality()");
+
+            // Enough ranges to use the prefix sums.
+            for (std::size_t i = 0; i < 100; ++i)
+                list.add({ 1000 + i * 10, 3 });
+
+            ofxTestEq(list.cardinality(), 314, "RangeList::cardinality()");
+
+            for (std::size_t k = 0; k < list.cardinality(); ++k)
+                ofxTestEq(list.rank(list.select(k)), k, "RangeList::rank(select())");
+
+            // The prefix sums are rebuilt by copies and carried by moves.
+            RangeList copy = list;
+            copy.add({ 5000, 10 });
+            ofxTestEq(copy.rank(5005), 319, "RangeList copy rank()");
+            ofxTestEq(list.rank(5005), 314, "RangeList copy rank()");
+
+            RangeList moved = std::move(copy);
+            ofxTestEq(moved.select(318), 5004, "RangeList move select()");
+            ofxTestEq(copy.empty(), true, "RangeList move");
+            ofxTestEq(copy.rank(5005), 0, "RangeList move rank()");
+
+            list.insert({ 0, 10 });
+            ofxTestEq(list.cardinality(), 314, "RangeList::cardinality()");
+            ofxTestEq(list.select(0), 20, "RangeList::select()");
+
+            list.erase({ 0, 1000 });
+            ofxTestEq(list.cardinality(), 300, "RangeList::cardinality()");
+            ofxTestEq(list.select(0), 10, "RangeList::select()");
+        }
+
+        {
+            RangeList list({ { 0, 10 }, { 15, 10 }, { 100, 10 } });
+
+            ofx::IndexRangeCoalesceSettings settings;
+            auto requests = list.coalesce(settings);
+            ofxTestEq(requests.size(), 3, "RangeList::coalesce()");
+
+            settings.maxGap = 5;
+            requests = list.coalesce(settings);
+            ofxTestEq(requests.size(), 2, "RangeList::coalesce()");
+            ofxTestEq(requests[0].range, Range(0, 25), "RangeList::coalesce()");
+            ofxTestEq(requests[0].ranges.size(), 2, "RangeList::coalesce()");
+            ofxTestEq(requests[0].ranges[1], Range(15, 10), "RangeList::coalesce()");
+            ofxTestEq(requests[1].range, Range(100, 10), "RangeList::coalesce()");
+
+            settings.alignment = 16;
+            requests = list.coalesce(settings);
+            ofxTestEq(requests.size(), 2, "RangeList::coalesce()");
+            ofxTestEq(requests[0].range, Range(0, 32), "RangeList::coalesce()");
+            ofxTestEq(requests[1].range, Range(96, 16), "RangeList::coalesce()");
+
+            settings.alignment = 1;
+            settings.maxSize = 8;
+            requests = list.coalesce(settings);
+            ofxTestEq(requests.size(), 6, "RangeList::coalesce()");
+            ofxTestEq(requests[0].range, Range(0, 8), "RangeList::coalesce()");
+            ofxTestEq(requests[1].range, Range(8, 8), "RangeList::coalesce()");
+            ofxTestEq(requests[1].ranges.size(), 2, "RangeList::coalesce()");
+            ofxTestEq(requests[1].ranges[1], Range(15, 1), "RangeList::coalesce()");
+
+            std::size_t total = 0;
+            for (auto& request: requests)
+                for (auto& range: request.ranges)
+                    total += range.size;
+            ofxTestEq(total, list.cardinality(), "RangeList::coalesce()");
+        }
+
+        {
+            std::string path = ofToDataPath("IndexRangeFileReader.bin", true);
+
+            {
+                std::ofstream stream(path, std::ios::binary);
+                for (std::size_t i = 0; i < 10000; ++i)
+                    stream.put(char(i % 251));
+            }
+
+            RangeList list({ { 5, 10 }, { 20, 3 }, { 4000, 100 }, { 9990, 10 } });
+
+            ofx::IndexRangeFileReader::Settings settings;
+            settings.coalesce.maxGap = 16;
+            settings.coalesce.alignment = 512;
+            settings.numThreads = 2;
+
+            std::vector<uint8_t> buffer;
+            ofxTestEq(ofx::IndexRangeFileReader::read(path, list, buffer, settings), true, "IndexRangeFileReader::read()");
+            ofxTestEq(buffer.size(), list.cardinality(), "IndexRangeFileReader::read()");
+
+            bool matches = buffer.size() == list.cardinality();
+            for (std::size_t k = 0; matches && k < buffer.size(); ++k)
+                matches = buffer[k] == list.select(k) % 251;
+            ofxTestEq(matches, true, "IndexRangeFileReader::read()");
+
+            // One slot per pool thread.
+            settings.numThreads = 0;
+            std::vector<uint8_t> pooled;
+            ofxTestEq(ofx::IndexRangeFileReader::read(path, list, pooled, settings), true, "IndexRangeFileReader::read() pool");
+            ofxTestEq(pooled == buffer, true, "IndexRangeFileReader::read() pool");
+
+            list.add({ 10000, 1 });
+            ofxTestEq(ofx::IndexRangeFileReader::read(path, list, buffer, settings), false, "IndexRangeFileReader::read()");
+
+            // Past the largest file offset.
+            RangeList high({ { Range::MAX - 10, 5 } });
+            ofxTestEq(ofx::IndexRangeFileReader::read(path, high, buffer, settings), false, "IndexRangeFileReader::read() offset");
+        }
+
+        {
+            ofx::IndexRangeDirtyTracker::Settings settings;
+            settings.granularity = 16;
+            settings.copyOverhead = 32;
+
+            ofx::IndexRangeDirtyTracker tracker(settings);
+            tracker.add({ 3, 2 });
+            tracker.add({ 40, 1 });
+            tracker.add({ 200, 1 });
+            ofxTestEq(tracker.dirtyBytes(), 48, "IndexRangeDirtyTracker::dirtyBytes()");
+
+            auto plan = tracker.plan(204);
+            ofxTestEq(plan.size(), 2, "IndexRangeDirtyTracker::plan()");
+            ofxTestEq(plan[0], Range(0, 48), "IndexRangeDirtyTracker::plan()");
+            ofxTestEq(plan[1], Range(192, 12), "IndexRangeDirtyTracker::plan()");
+
+            std::vector<uint8_t> source(204, 1);
+            std::vector<uint8_t> destination(204, 0);
+            ofxTestEq(tracker.flush(source.data(), destination.data(), source.size()), 60, "IndexRangeDirtyTracker::flush()");
+            ofxTestEq(tracker.empty(), true, "IndexRangeDirtyTracker::flush()");
+            ofxTestEq(destination[47], 1, "IndexRangeDirtyTracker::flush()");
+            ofxTestEq(destination[48], 0, "IndexRangeDirtyTracker::flush()");
+            ofxTestEq(destination[203], 1, "IndexRangeDirtyTracker::flush()");
+        }
+
+        {
+            RangeList a({ { 0, 10 }, { 20, 10 }, { 40, 10 } });
+            RangeList b({ { 5, 20 }, { 45, 10 } });
+
+            auto testList = [&](const RangeList& list,
+                                const std::vector<Range>& results,
+                                const std::string& name)
+            {
+                ofxTestEq(list.size(), results.size(), name);
+                for (std::size_t i = 0; i < results.size() && i < list.size(); ++i)
+                    ofxTestEq(list.ranges()[i], results[i], name);
+            };
+
+            testList(a.unionWith(b), { { 0, 30 }, { 40, 15 } }, "RangeList::unionWith()");
+            testList(a.intersectionWith(b), { { 5, 5 }, { 20, 5 }, { 45, 5 } }, "RangeList::intersectionWith()");
+            testList(a.differenceWith(b), { { 0, 5 }, { 25, 5 }, { 40, 5 } }, "RangeList::differenceWith()");
+            testList(b.differenceWith(a), { { 10, 10 }, { 50, 5 } }, "RangeList::differenceWith()");
+
+            // Force the parallel paths.
+            std::size_t threshold = ofx::IndexRangeParallel::threshold();
+            std::size_t numThreads = ofx::IndexRangeParallel::numThreads();
+            ofx::IndexRangeParallel::setThreshold(8);
+            ofx::IndexRangeParallel::setNumThreads(4);
+
+            RangeList c;
+            RangeList d;
+            for (std::size_t i = 0; i < 1000; ++i)
+            {
+                c.add({ (i * 7919) % 1000 * 10, 5 });
+                d.add({ i * 10 + 3, 4 });
+            }
+
+            ofxTestEq(c.size(), 1000, "RangeList::_sort()");
+            ofxTestEq(c.ranges()[999], Range(9990, 5), "RangeList::_sort()");
+            ofxTestEq(c.unionWith(d).cardinality(), 7000, "RangeList::unionWith()");
+            ofxTestEq(c.intersectionWith(d).cardinality(), 2000, "RangeList::intersectionWith()");
+            ofxTestEq(c.differenceWith(d).cardinality(), 3000, "RangeList::differenceWith()");
+            ofxTestEq(c.unionWith(d).size(), 1000, "RangeList::unionWith()");
+
+            ofx::IndexRangeParallel::setThreshold(threshold);
+            ofx::IndexRangeParallel::setNumThreads(numThreads);
+        }
+
+        {
+            // Large enough for the radix sort.
+            RangeList list;
+            for (std::size_t i = 0; i < 10000; ++i)
+                list.add({ ((i * 7919) % 10000) * 1000000000, 5 });
+            for (std::size_t i = 0; i < 10000; ++i)
+                list.add({ ((i * 104729) % 10000) * 1000000000 + 3, 5 });
+
+            ofxTestEq(list.size(), 10000, "RangeList::_sort()");
+            ofxTestEq(list.cardinality(), 80000, "RangeList::_sort()");
+            ofxTestEq(list.ranges()[0], Range(0, 8), "RangeList::_sort()");
+            ofxTestEq(list.ranges()[9999], Range(9999000000000, 8), "RangeList::_sort()");
+        }
+
+        {
+            // A sorted prefix followed by a tail large enough for the radix
+            // sort, merged into the output in one pass.
+            RangeList list;
+            std::vector<Range> expected;
+
+            for (std::size_t i = 0; i < 2000; ++i)
+            {
+                list.add({ i * 100, 10 });
+                expected.push_back({ i * 100, 10 });
+            }
+
+            for (std::size_t i = 0; i < 5000; ++i)
+            {
+                Range range((i * 7919) % 5000 * 40 + 5, 10);
+                list.add(range);
+                expected.push_back(range);
+            }
+
+            std::sort(expected.begin(), expected.end());
+
+            RangeList merged;
+            for (auto& range: expected)
+                merged.add(range);
+
+            ofxTestEq(list == merged, true, "RangeList::_sort() prefix");
+            ofxTestEq(list.cardinality(), merged.cardinality(), "RangeList::_sort() prefix");
+            ofxTestEq(list.hash(), merged.hash(), "RangeList::_sort() prefix");
+        }
+
+        {
+            RangeList list;
+            list.add({ 0, 10 });
+            ofxTestEq(list.size(), 1, "RangeList::add()");
+
+            // Appended in order.
+            list.add({ 10, 5 });
+            list.add({ 20, 5 });
+            list.add({ 22, 10 });
+            ofxTestEq(list.size(), 2, "RangeList::add()");
+            ofxTestEq(list.cardinality(), 27, "RangeList::add()");
+
+            // Out of order, close to the tail.
+            list.add({ 16, 2 });
+            ofxTestEq(list.size(), 3, "RangeList::add()");
+            ofxTestEq(list.ranges()[1], Range(16, 2), "RangeList::add()");
+            list.add({ 15, 1 });
+            ofxTestEq(list.size(), 2, "RangeList::add()");
+            ofxTestEq(list.ranges()[0], Range(0, 18), "RangeList::add()");
+            list.add({ 18, 2 });
+            ofxTestEq(list.size(), 1, "RangeList::add()");
+            ofxTestEq(list.ranges()[0], Range(0, 32), "RangeList::add()");
+            ofxTestEq(list.cardinality(), 32, "RangeList::add()");
+        }
+
+        {
+            ofx::IndexRangeStream stream;
+            stream.add({ 10, 10 });
+            stream.add({ 30, 10 });
+            ofxTestEq(stream.contiguousPrefixEnd(), 0, "IndexRangeStream::contiguousPrefixEnd()");
+
+            stream.add({ 0, 5 });
+            ofxTestEq(stream.contiguousPrefixEnd(), 5, "IndexRangeStream::contiguousPrefixEnd()");
+
+            stream.add({ 5, 5 });
+            ofxTestEq(stream.size(), 2, "IndexRangeStream::add()");
+            ofxTestEq(stream.contiguousPrefixEnd(), 20, "IndexRangeStream::contiguousPrefixEnd()");
+
+            stream.advanceWatermark(15);
+            ofxTestEq(stream.watermark(), 15, "IndexRangeStream::advanceWatermark()");
+            ofxTestEq(stream[0], Range(15, 5), "IndexRangeStream::advanceWatermark()");
+            ofxTestEq(stream.cardinality(), 15, "IndexRangeStream::cardinality()");
+
+            stream.advanceWatermark(25);
+            ofxTestEq(stream.size(), 1, "IndexRangeStream::advanceWatermark()");
+            ofxTestEq(stream.contiguousPrefixEnd(), 25, "IndexRangeStream::contiguousPrefixEnd()");
+
+            // Below the watermark.
+            stream.add({ 0, 26 });
+            ofxTestEq(stream[0], Range(25, 1), "IndexRangeStream::add()");
+
+            stream.add({ 26, 4 });
+            ofxTestEq(stream.size(), 1, "IndexRangeStream::add()");
+            ofxTestEq(stream.contiguousPrefixEnd(), 40, "IndexRangeStream::contiguousPrefixEnd()");
+
+            for (std::size_t i = 0; i < 100; ++i)
+                stream.add({ 100 + i * 10, 5 });
+
+            stream.advanceWatermark(1000);
+            ofxTestEq(stream.size(), 10, "IndexRangeStream::advanceWatermark()");
+            ofxTestEq(stream.cardinality(), 50, "IndexRangeStream::cardinality()");
+        }
+
+        {
+            using Rect = ofx::IndexRangeRect;
+            using Region = ofx::IndexRangeRegion;
+
+            Region region(Rect(0, 0, 10, 10));
+            region.add(Rect(5, 5, 10, 10));
+            ofxTestEq(region.area(), 175, "IndexRangeRegion::add()");
+            ofxTestEq(region.rects().size(), 3, "IndexRangeRegion::rects()");
+            ofxTestEq(region.bounds(), Rect(0, 0, 15, 15), "IndexRangeRegion::bounds()");
+            ofxTestEq(region.contains(12, 2), false, "IndexRangeRegion::contains()");
+            ofxTestEq(region.contains(12, 12), true, "IndexRangeRegion::contains()");
+
+            // Adjacent rectangles coalesce.
+            Region strip(Rect(0, 0, 10, 5));
+            strip.add(Rect(0, 5, 10, 5));
+            ofxTestEq(strip.rects().size(), 1, "IndexRangeRegion::rects()");
+            ofxTestEq(strip.rects()[0], Rect(0, 0, 10, 10), "IndexRangeRegion::rects()");
+
+            region.remove(Rect(2, 2, 6, 6));
+            ofxTestEq(region.area(), 175 - 36, "IndexRangeRegion::remove()");
+
+            region.intersect(Rect(0, 0, 10, 10));
+            ofxTestEq(region.area(), 100 - 36, "IndexRangeRegion::intersect()");
+            ofxTestEq(region.rects().size(), 4, "IndexRangeRegion::rects()");
+
+            auto bounded = region.rects(2);
+            ofxTestEq(bounded.size(), 2, "IndexRangeRegion::rects(maxCount)");
+
+            region.remove(Rect(0, 0, 10, 10));
+            ofxTestEq(region.empty(), true, "IndexRangeRegion::remove()");
+        }
+
+        {
+            ofx::PersistentIndexRangeList list(RangeList({ { 0, 10 }, { 20, 10 } }));
+            ofx::IndexRangeListHistory history(list);
+
+            list.add({ 10, 5 });
+            history.commit(list);
+            list.remove({ 5, 20 });
+            history.commit(list);
+            list.insert({ 2, 3 });
+            history.commit(list);
+            list.erase({ 0, 4 });
+            history.commit(list);
+
+            ofxTestEq(history.size(), 5, "IndexRangeListHistory::commit()");
+            ofxTestEq(list.size(), 2, "PersistentIndexRangeList::erase()");
+            ofxTestEq(list.ranges()[0], Range(0, 4), "PersistentIndexRangeList::erase()");
+            ofxTestEq(list.ranges()[1], Range(24, 5), "PersistentIndexRangeList::erase()");
+            ofxTestEq(list.cardinality(), 9, "PersistentIndexRangeList::cardinality()");
+            ofxTestEq(list.contains(24), true, "PersistentIndexRangeList::contains()");
+
+            // Erasing shifts by wrapping around, which must be exact near MAX.
+            ofx::PersistentIndexRangeList high(RangeList({ { 10, 5 }, { Range::MAX - 20, 5 }, { Range::MAX - 10, 10 } }));
+            high.erase({ 0, 10 });
+            high.erase({ Range::MAX - 50, 15 });
+            ofxTestEq(high.size(), 3, "PersistentIndexRangeList::erase() high");
+            ofxTestEq(high.ranges()[0], Range(0, 5), "PersistentIndexRangeList::erase() high");
+            ofxTestEq(high.ranges()[1], Range(Range::MAX - 45, 5), "PersistentIndexRangeList::erase() high");
+            ofxTestEq(high.ranges()[2], Range(Range::MAX - 35, 10), "PersistentIndexRangeList::erase() high");
+            ofxTestEq(high.contains(Range::MAX - 36), false, "PersistentIndexRangeList::erase() high");
+            ofxTestEq(high.contains(Range::MAX - 26), true, "PersistentIndexRangeList::erase() high");
+            ofxTestEq(high.contains(Range::MAX - 25), false, "PersistentIndexRangeList::erase() high");
+
+            ofxTestEq(history.undo(), true, "IndexRangeListHistory::undo()");
+            ofxTestEq(history.current().ranges()[0], Range(0, 8), "IndexRangeListHistory::undo()");
+            ofxTestEq(history.undo(), true, "IndexRangeListHistory::undo()");
+            ofxTestEq(history.undo(), true, "IndexRangeListHistory::undo()");
+            ofxTestEq(history.current().ranges()[0], Range(0, 15), "IndexRangeListHistory::undo()");
+            ofxTestEq(history.current().ranges()[1], Range(20, 10), "IndexRangeListHistory::undo()");
+            ofxTestEq(history.redo(), true, "IndexRangeListHistory::redo()");
+            ofxTestEq(history.current().ranges()[1], Range(25, 5), "IndexRangeListHistory::redo()");
+
+            history.commit(ofx::PersistentIndexRangeList());
+            ofxTestEq(history.canRedo(), false, "IndexRangeListHistory::commit()");
+            ofxTestEq(history.current().empty(), true, "IndexRangeListHistory::commit()");
+
+            // Earlier versions are unaffected by later edits.
+            ofx::PersistentIndexRangeList copy = list;
+            ofxTestEq(copy.isSameVersion(list), true, "PersistentIndexRangeList::isSameVersion()");
+            copy.add({ 100, 1 });
+            ofxTestEq(copy.isSameVersion(list), false, "PersistentIndexRangeList::isSameVersion()");
+            ofxTestEq(list.size(), 2, "PersistentIndexRangeList copy");
+            ofxTestEq(copy.toList().size(), 3, "PersistentIndexRangeList::toList()");
+        }
+
+        {
+            RangeList list({ { 0, 10 }, { 20, 10 }, { 40, 10 } });
+
+            // Batched edits match sequential edits in decreasing order.
+            RangeList expected = list;
+            expected.erase({ 42, 4 });
+            expected.insert({ 25, 5 });
+            expected.erase({ 5, 20 });
+
+            list.apply({ ofx::IndexRangeEdit::erase({ 5, 20 }),
+                         ofx::IndexRangeEdit::insert({ 25, 5 }),
+                         ofx::IndexRangeEdit::erase({ 42, 4 }) });
+
+            ofxTestEq(list == expected, true, "IndexRangeList::apply()");
+            ofxTestEq(list.size(), 2, "IndexRangeList::apply()");
+            ofxTestEq(list.cardinality(), 21, "IndexRangeList::apply()");
+
+            list.apply({ ofx::IndexRangeEdit::insert({ 0, Range::MAX }) });
+            ofxTestEq(list.size(), 1, "IndexRangeList::apply() overflow");
+            ofxTestEq(list.ranges()[0].getMax(), Range::MAX, "IndexRangeList::apply() overflow");
+        }
+
+        {
+            ofx::IndexRangeMapper mapper;
+            ofxTestEq(mapper.isIdentity(), true, "IndexRangeMapper::isIdentity()");
+            ofxTestEq(mapper.map(42), 42, "IndexRangeMapper::map()");
+
+            mapper.insert({ 10, 5 });
+            mapper.erase({ 20, 10 });
+
+            ofxTestEq(mapper.isIdentity(), false, "IndexRangeMapper::isIdentity()");
+            ofxTestEq(mapper.map(10), 10, "IndexRangeMapper::map() insert");
+            ofxTestEq(mapper.map(11), 16, "IndexRangeMapper::map() insert");
+            ofxTestEq(mapper.map(15), 20, "IndexRangeMapper::map() erase start");
+            ofxTestEq(mapper.map(20), 20, "IndexRangeMapper::map() erased");
+            ofxTestEq(mapper.map(25), 20, "IndexRangeMapper::map() erase end");
+            ofxTestEq(mapper.map(30), 25, "IndexRangeMapper::map()");
+            ofxTestEq(mapper.isErased(20), true, "IndexRangeMapper::isErased()");
+            ofxTestEq(mapper.isErased(25), false, "IndexRangeMapper::isErased()");
+            ofxTestEq(mapper.map(20, ofx::IndexRangeMapper::Policy::INVALID), Range::MAX, "IndexRangeMapper::map() invalid");
+
+            std::vector<std::size_t> indices = { 30, 0, 11 };
+            std::vector<std::size_t> expected = { 25, 0, 16 };
+            ofxTestEq(mapper.map(indices) == expected, true, "IndexRangeMapper::map() batch");
+
+            RangeList list({ { 5, 10 }, { 22, 10 } });
+            RangeList sequential = list;
+            sequential.insert({ 10, 5 });
+            sequential.erase({ 20, 10 });
+            list.apply(mapper);
+            ofxTestEq(list == sequential, true, "IndexRangeList::apply() mapper");
+
+            // Indices moved past the end stay there.
+            ofx::IndexRangeMapper high;
+            high.insert({ Range::MAX - 10, 5 });
+            high.erase({ 0, 100 });
+            ofxTestEq(high.map(Range::MAX - 10), Range::MAX - 110, "IndexRangeMapper::map() high");
+            ofxTestEq(high.map(Range::MAX - 6), Range::MAX - 101, "IndexRangeMapper::map() high");
+            ofxTestEq(high.map(Range::MAX - 5), Range::MAX - 100, "IndexRangeMapper::map() high");
+            ofxTestEq(high.map(Range::MAX - 4), Range::MAX, "IndexRangeMapper::map() lost");
+            ofxTestEq(high.map(Range::MAX), Range::MAX, "IndexRangeMapper::map() lost");
+        }
+
+        {
+            RangeList list({ { 1, 2 }, { 5, 1 }, { 8, 10 } });
+
+            std::vector<int> values = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+            std::vector<int> gathered = ofx::IndexRangeAlgorithms::gather(list, values);
+            ofxTestEq(gathered == std::vector<int>({ 1, 2, 5, 8, 9 }), true, "IndexRangeAlgorithms::gather()");
+
+            std::vector<int> scattered(10, -1);
+            ofxTestEq(ofx::IndexRangeAlgorithms::scatter(list, gathered, scattered), 5, "IndexRangeAlgorithms::scatter()");
+            ofxTestEq(scattered == std::vector<int>({ -1, 1, 2, -1, -1, 5, -1, -1, 8, 9 }), true, "IndexRangeAlgorithms::scatter()");
+
+            ofx::IndexRangeAlgorithms::compactErase(list, values);
+            ofxTestEq(values == std::vector<int>({ 0, 3, 4, 6, 7 }), true, "IndexRangeAlgorithms::compactErase()");
+
+            std::vector<std::string> strings = { "a", "b", "c", "d" };
+            ofx::IndexRangeAlgorithms::compactErase(RangeList({ { 0, 1 }, { 2, 1 } }), strings);
+            ofxTestEq(strings == std::vector<std::string>({ "b", "d" }), true, "IndexRangeAlgorithms::compactErase() non-trivial");
+        }
+
+        {
+            ofx::CheckedIndexRangeList checked;
+            checked.add({ 8, 10 });
+            checked.add({ 1, 2 });
+
+            ofxTestEq(checked.end() - checked.begin(), 2, "IndexRangeList::begin() end()");
+            ofxTestEq(*checked.begin(), Range(1, 2), "IndexRangeList::begin() sorted");
+
+            std::vector<int> values = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+            ofxTestEq(ofx::IndexRangeAlgorithms::gather(checked, values) == std::vector<int>({ 1, 2, 8, 9 }), true, "IndexRangeAlgorithms::gather() checked");
+
+            ofx::UncheckedIndexRangeList unchecked;
+            unchecked.add({ 0, 1 });
+            unchecked.add({ 2, 1 });
+
+            std::vector<int> scattered(4, -1);
+            ofxTestEq(ofx::IndexRangeAlgorithms::scatter(unchecked, std::vector<int>({ 7, 8 }), scattered), 2, "IndexRangeAlgorithms::scatter() unchecked");
+            ofxTestEq(scattered == std::vector<int>({ 7, -1, 8, -1 }), true, "IndexRangeAlgorithms::scatter() unchecked");
+
+            ofx::IndexRangeAlgorithms::compactErase(unchecked, values);
+            ofxTestEq(values == std::vector<int>({ 1, 3, 4, 5, 6, 7, 8, 9 }), true, "IndexRangeAlgorithms::compactErase() unchecked");
+        }
+
+        {
+            RangeList list({ { 1, 2 }, { 60, 80 }, { 190, 20 } });
+
+            std::vector<uint64_t> bits = list.toBitset(200);
+            ofxTestEq(bits.size(), 4, "IndexRangeList::toBitset()");
+            ofxTestEq(bits[0], (uint64_t(0xF) << 60) | 0x6, "IndexRangeList::toBitset()");
+            ofxTestEq(bits[1], ~uint64_t(0), "IndexRangeList::toBitset()");
+            ofxTestEq(bits[3], uint64_t(0xFF), "IndexRangeList::toBitset()");
+
+            RangeList clipped = RangeList::fromBitset(bits);
+            ofxTestEq(clipped == RangeList({ { 1, 2 }, { 60, 80 }, { 190, 10 } }), true, "IndexRangeList::fromBitset()");
+            ofxTestEq(RangeList::fromBitset(bits.data(), 191).cardinality(), 83, "IndexRangeList::fromBitset()");
+
+            ofxTestEq(list.isSmallerAsBitset(200), true, "IndexRangeList::isSmallerAsBitset()");
+            ofxTestEq(list.isSmallerAsBitset(100000), false, "IndexRangeList::isSmallerAsBitset()");
+            ofxTestEq(RangeList::fromBitset({ 0x5555555555555555 }).isSmallerAsBitset(64), true, "IndexRangeList::isSmallerAsBitset()");
+        }
+
+        {
+            typedef ofx::IndexRangeSetChunk::Type Type;
+
+            // Every other index of the first chunk, a few points in the
+            // second and a long run over the next chunks.
+            RangeList list;
+
+            for (std::size_t i = 0; i < 65536; i += 2)
+                list.add({ i, 1 });
+
+            list.add({ 65536 + 10, 1 });
+            list.add({ 65536 + 20, 1 });
+            list.add({ 3 * 65536, 100000 });
+
+            ofx::IndexRangeSet set(list);
+            ofxTestEq(set.chunks().size(), 4, "IndexRangeSet::chunks()");
+            ofxTestEq(set.chunks()[0].type == Type::BITMAP, true, "IndexRangeSet bitmap chunk");
+            ofxTestEq(set.chunks()[1].type == Type::ARRAY, true, "IndexRangeSet array chunk");
+            ofxTestEq(set.chunks()[2].type == Type::RUN, true, "IndexRangeSet run chunk");
+            ofxTestEq(set.cardinality(), list.cardinality(), "IndexRangeSet::cardinality()");
+            ofxTestEq(set.sizeInBytes() < list.size() * sizeof(Range), true, "IndexRangeSet::sizeInBytes()");
+            ofxTestEq(set.contains(4), true, "IndexRangeSet::contains()");
+            ofxTestEq(set.contains(5), false, "IndexRangeSet::contains()");
+            ofxTestEq(set.toList() == list, true, "IndexRangeSet::toList()");
+
+            set.remove({ 0, 65536 - 8000 });
+            ofxTestEq(set.chunks()[0].type == Type::ARRAY, true, "IndexRangeSet::remove() converts");
+
+            set.add(11 + 65536);
+            ofxTestEq(set.contains(11 + 65536), true, "IndexRangeSet::add()");
+
+            ofx::IndexRangeSet other(RangeList({ { 65536, 65536 } }));
+            ofxTestEq(set.intersectionWith(other).cardinality(), 3, "IndexRangeSet::intersectionWith()");
+            ofxTestEq(set.differenceWith(other).cardinality(), set.cardinality() - 3, "IndexRangeSet::differenceWith()");
+            ofxTestEq(set.unionWith(other).cardinality(), set.cardinality() + 65536 - 3, "IndexRangeSet::unionWith()");
+            ofxTestEq(set.unionWith(other).differenceWith(other) == set.differenceWith(other), true, "IndexRangeSet::operator==()");
+        }
+
+        {
+            // Mix range edits on a set with dense bitmap and array chunks,
+            // checked against a list with the same edits.
+            RangeList list;
+
+            for (std::size_t i = 0; i < 4 * 65536; i += 3)
+                list.add({ i, 1 });
+
+            ofx::IndexRangeSet set(list);
+
+            for (std::size_t i = 0; i < 2000; ++i)
+            {
+                Range range((i * 7919) % (5 * 65536), (i * 104729) % (i % 3 == 0 ? 70000 : 5000));
+
+                if (i % 3 == 0)
+                {
+                    set.remove(range);
+                    list.remove(range);
+                }
+                else
+                {
+                    set.add(range);
+                    list.add(range);
+                }
+            }
+
+            ofxTestEq(set.cardinality(), list.cardinality(), "IndexRangeSet::add() remove() cardinality");
+            ofxTestEq(set.toList() == list, true, "IndexRangeSet::add() remove()");
+            ofxTestEq(set == ofx::IndexRangeSet(list), true, "IndexRangeSet::add() remove() operator==()");
+        }
+
+        {
+            ofx::CircularIndexRange range(14, 6, 16);
+            ofxTestEq(range.wraps(), true, "CircularIndexRange::wraps()");
+            ofxTestEq(range.numSpans(), 2, "CircularIndexRange::numSpans()");
+            ofxTestEq(range.first(), Range(14, 2), "CircularIndexRange::first()");
+            ofxTestEq(range.second(), Range(0, 4), "CircularIndexRange::second()");
+            ofxTestEq(range.getMax(), 4, "CircularIndexRange::getMax()");
+            ofxTestEq(range.contains(15), true, "CircularIndexRange::contains()");
+            ofxTestEq(range.contains(19), true, "CircularIndexRange::contains()");
+            ofxTestEq(range.contains(4), false, "CircularIndexRange::contains()");
+            ofxTestEq(ofx::CircularIndexRange(35, 100, 16), ofx::CircularIndexRange(3, 16, 16), "CircularIndexRange wrapped and clamped");
+
+            ofx::CircularIndexRangeList list(16);
+            list.add({ 12, 2, 16 });
+            list.add({ 14, 6, 16 });
+            list.add({ 6, 2, 16 });
+            ofxTestEq(list.size(), 2, "CircularIndexRangeList::add()");
+            ofxTestEq(list.cardinality(), 10, "CircularIndexRangeList::cardinality()");
+            ofxTestEq(list.ranges()[1], ofx::CircularIndexRange(12, 8, 16), "CircularIndexRangeList::ranges() wrapped");
+
+            // Keep writing around the ring without adding ranges.
+            for (std::size_t i = 0; i < 100; ++i)
+                list.add({ 20 + i, 1, 16 });
+
+            ofxTestEq(list.size(), 1, "CircularIndexRangeList::add() full");
+            ofxTestEq(list.cardinality(), 16, "CircularIndexRangeList::add() full");
+
+            list.remove({ 30, 4, 16 });
+            ofxTestEq(list.size(), 1, "CircularIndexRangeList::remove()");
+            ofxTestEq(list.ranges()[0], ofx::CircularIndexRange(2, 12, 16), "CircularIndexRangeList::remove()");
+            ofxTestEq(list.contains(14), false, "CircularIndexRangeList::contains()");
+            ofxTestEq(list.contains(18), true, "CircularIndexRangeList::contains()");
+        }
+
+        {
+            ofx::CheckedIndexRangeList checked;
+            checked.add({ 10, 10 });
+
+            bool threw = false;
+
+            try
+            {
+                checked.add({ Range::MAX - 5, 10 });
+            }
+            catch (const std::overflow_error&)
+            {
+                threw = true;
+            }
+
+            ofxTestEq(threw, true, "CheckedIndexRangeList::add() overflow");
+            ofxTestEq(checked.size(), 1, "CheckedIndexRangeList::add() overflow");
+
+            threw = false;
+
+            try
+            {
+                checked.insert({ 0, Range::MAX - 10 });
+            }
+            catch (const std::overflow_error&)
+            {
+                threw = true;
+            }
+
+            ofxTestEq(threw, true, "CheckedIndexRangeList::insert() overflow");
+            ofxTestEq(checked.ranges()[0], Range(10, 10), "CheckedIndexRangeList::insert() overflow");
+
+            RangeList clamped;
+            clamped.add({ 10, 10 });
+            clamped.insert({ 0, Range::MAX - 10 });
+            ofxTestEq(clamped.size(), 0, "IndexRangeList::insert() overflow");
+
+            ofx::UncheckedIndexRangeList unchecked;
+            unchecked.add({ 10, 10 });
+            unchecked.add({ 30, 10 });
+            unchecked.insert({ 15, 5 });
+            ofxTestEq(unchecked.ranges()[0], Range(10, 15), "UncheckedIndexRangeList::insert()");
+            ofxTestEq(unchecked.ranges()[1], Range(35, 10), "UncheckedIndexRangeList::insert()");
+            ofxTestEq(unchecked.cardinality(), 25, "UncheckedIndexRangeList::cardinality()");
+
+            unchecked.apply({ ofx::IndexRangeEdit::insert({ 0, 5 }), ofx::IndexRangeEdit::erase({ 35, 5 }) });
+            ofxTestEq(unchecked.ranges()[0], Range(15, 15), "UncheckedIndexRangeList::apply()");
+            ofxTestEq(unchecked.ranges()[1], Range(40, 5), "UncheckedIndexRangeList::apply()");
+
+            ofx::IndexRangeMapper shift({ ofx::IndexRangeEdit::insert({ 0, 100 }) });
+            unchecked.apply(shift);
+            ofxTestEq(unchecked.ranges()[0], Range(115, 15), "UncheckedIndexRangeList::apply() mapper");
+
+            ofx::CheckedIndexRangeList high;
+            high.add({ Range::MAX - 10, 5 });
+
+            std::string message;
+
+            try
+            {
+                high.apply({ ofx::IndexRangeEdit::insert({ 0, 100 }) });
+            }
+            catch (const std::overflow_error& error)
+            {
+                message = error.what();
+            }
+
+            ofxTestEq(message, "IndexRange {" + std::to_string(Range::MAX - 10) + ",5} overflows.", "CheckedIndexRangeList::apply() overflow");
+            ofxTestEq(high.ranges()[0], Range(Range::MAX - 10, 5), "CheckedIndexRangeList::apply() overflow");
+
+            threw = false;
+
+            try
+            {
+                high.apply(shift);
+            }
+            catch (const std::overflow_error&)
+            {
+                threw = true;
+            }
+
+            ofxTestEq(threw, true, "CheckedIndexRangeList::apply() mapper overflow");
+            ofxTestEq(high.ranges()[0], Range(Range::MAX - 10, 5), "CheckedIndexRangeList::apply() mapper overflow");
+
+            high.apply({ ofx::IndexRangeEdit::insert({ 0, 5 }) });
+            high.apply(ofx::IndexRangeMapper({ ofx::IndexRangeEdit::erase({ 0, 10 }) }));
+            ofxTestEq(high.ranges()[0], Range(Range::MAX - 15, 5), "CheckedIndexRangeList::apply()");
+
+            message.clear();
+
+            try
+            {
+                high.insert({ 0, 100 });
+            }
+            catch (const std::overflow_error& error)
+            {
+                message = error.what();
+            }
+
+            ofxTestEq(message, "IndexRange {" + std::to_string(Range::MAX - 15) + ",5} overflows.", "CheckedIndexRangeList::insert() overflow");
+
+            RangeList dropped;
+            dropped.add({ Range::MAX - 10, 5 });
+            dropped.apply({ ofx::IndexRangeEdit::insert({ 0, 100 }) });
+            ofxTestEq(dropped.empty(), true, "IndexRangeList::apply() overflow");
+        }
+
+        {
+            // Moving an end exactly to MAX does not overflow.
+            ofx::IndexRangeEdit edit = ofx::IndexRangeEdit::insert({ 5, Range::MAX - 10 });
+            ofx::IndexRangeMapper mapper({ edit });
+
+            ofxTestEq(mapper.map(10), Range::MAX, "IndexRangeMapper::map() exact");
+            ofxTestEq(mapper.isLost(10), false, "IndexRangeMapper::isLost() exact");
+            ofxTestEq(mapper.isLost(11), true, "IndexRangeMapper::isLost()");
+            ofxTestEq(mapper.isLost(5), false, "IndexRangeMapper::isLost()");
+
+            ofx::CheckedIndexRangeList inserted({ { 0, 10 } });
+            ofx::CheckedIndexRangeList edited({ { 0, 10 } });
+            ofx::CheckedIndexRangeList mapped({ { 0, 10 } });
+
+            inserted.insert(edit.range);
+            edited.apply({ edit });
+            mapped.apply(mapper);
+
+            ofxTestEq(inserted.ranges()[0], Range(0, Range::MAX), "CheckedIndexRangeList::insert() exact");
+            ofxTestEq(edited.ranges()[0], Range(0, Range::MAX), "CheckedIndexRangeList::apply() exact");
+            ofxTestEq(mapped.ranges()[0], Range(0, Range::MAX), "CheckedIndexRangeList::apply() mapper exact");
+
+            bool threw = false;
+
+            try
+            {
+                ofx::CheckedIndexRangeList past({ { 0, 11 } });
+                past.apply(mapper);
+            }
+            catch (const std::overflow_error&)
+            {
+                threw = true;
+            }
+
+            ofxTestEq(threw, true, "CheckedIndexRangeList::apply() mapper overflow");
+        }
+
+        {
+            ofx::IndexRangeIntervalTree tree;
+            tree.add({ 10, 10 }, 1);
+            tree.add({ 15, 10 }, 2);
+            tree.add({ 40, 5 }, 3);
+            tree.add({ 12, 0 }, 4);
+            ofxTestEq(tree.size(), 4, "IndexRangeIntervalTree::size()");
+
+            auto stabbed = tree.stab(16);
+            ofxTestEq(stabbed.size(), 2, "IndexRangeIntervalTree::stab()");
+            ofxTestEq(stabbed[0].id, 1, "IndexRangeIntervalTree::stab()");
+            ofxTestEq(stabbed[1].id, 2, "IndexRangeIntervalTree::stab()");
+            ofxTestEq(tree.stab(12).size(), 1, "IndexRangeIntervalTree::stab() empty");
+            ofxTestEq(tree.stab(25).size(), 0, "IndexRangeIntervalTree::stab()");
+
+            auto overlapping = tree.overlapping({ 20, 25 });
+            ofxTestEq(overlapping.size(), 2, "IndexRangeIntervalTree::overlapping()");
+            ofxTestEq(overlapping[0].id, 2, "IndexRangeIntervalTree::overlapping()");
+            ofxTestEq(overlapping[1].id, 3, "IndexRangeIntervalTree::overlapping()");
+
+            ofx::IndexRangeIntervalTree other;
+            other.add({ 0, 11 }, 7);
+            other.add({ 20, 20 }, 8);
+            auto pairs = other.join(tree);
+            ofxTestEq(pairs.size(), 2, "IndexRangeIntervalTree::join()");
+            ofxTestEq(pairs[0].first, 7, "IndexRangeIntervalTree::join()");
+            ofxTestEq(pairs[0].second, 1, "IndexRangeIntervalTree::join()");
+            ofxTestEq(pairs[1].first, 8, "IndexRangeIntervalTree::join()");
+            ofxTestEq(pairs[1].second, 2, "IndexRangeIntervalTree::join()");
+        }
+
+        {
+            RangeList a;
+            a.add({ 0, 10 });
+            a.add({ 20, 10 });
+
+            RangeList b;
+            b.add({ 5, 20 });
+
+            ofx::IndexRangeListIndex index;
+            index.set(1, a);
+            index.set(2, b);
+            ofxTestEq(index.size(), 2, "IndexRangeListIndex::size()");
+            ofxTestEq(index.stab(7).size(), 2, "IndexRangeListIndex::stab()");
+            ofxTestEq(index.stab(15).size(), 1, "IndexRangeListIndex::stab()");
+            ofxTestEq(index.stab(15)[0], 2, "IndexRangeListIndex::stab()");
+            ofxTestEq(index.overlapping({ 12, 10 }).size(), 2, "IndexRangeListIndex::overlapping()");
+            ofxTestEq(index.covering({ 12, 10 }).size(), 1, "IndexRangeListIndex::covering()");
+            ofxTestEq(index.covering({ 12, 10 })[0], 2, "IndexRangeListIndex::covering()");
+
+            index.compact();
+            RangeList c;
+            c.add({ 40, 10 });
+            index.set(2, c);
+            ofxTestEq(index.stab(15).size(), 0, "IndexRangeListIndex::set() replace");
+            ofxTestEq(index.stab(45)[0], 2, "IndexRangeListIndex::set() replace");
+
+            ofxTestEq(index.remove(1), true, "IndexRangeListIndex::remove()");
+            ofxTestEq(index.remove(1), false, "IndexRangeListIndex::remove()");
+            ofxTestEq(index.stab(7).size(), 0, "IndexRangeListIndex::remove()");
+            ofxTestEq(index.size(), 1, "IndexRangeListIndex::size()");
+        }
+
+        {
+            ofx::IndexRangeCache cache(16);
+            cache.insert(0, std::vector<uint8_t>({ 0, 1, 2, 3 }));
+            cache.insert(4, std::vector<uint8_t>({ 4, 5, 6, 7 }));
+            ofxTestEq(cache.numChunks(), 1, "IndexRangeCache::insert() merge");
+            ofxTestEq(cache.size(), 8, "IndexRangeCache::size()");
+
+            cache.insert(12, std::vector<uint8_t>({ 12, 13 }));
+
+            auto result = cache.lookup({ 2, 12 });
+            ofxTestEq(result.pieces.size(), 2, "IndexRangeCache::lookup()");
+            ofxTestEq(result.pieces[0].range, Range(2, 6), "IndexRangeCache::lookup()");
+            ofxTestEq(int(result.pieces[0].data[0]), 2, "IndexRangeCache::lookup()");
+            ofxTestEq(result.pieces[1].range, Range(12, 2), "IndexRangeCache::lookup()");
+            ofxTestEq(result.missing.size(), 1, "IndexRangeCache::lookup() missing");
+            ofxTestEq(result.missing.ranges()[0], Range(8, 4), "IndexRangeCache::lookup() missing");
+
+            cache.erase({ 3, 2 });
+            ofxTestEq(cache.numChunks(), 3, "IndexRangeCache::erase()");
+            ofxTestEq(cache.size(), 8, "IndexRangeCache::erase()");
+
+            // [5, 8) keeps the recency of the chunk it was split from, which
+            // makes it the least recently used.
+            cache.insert(20, std::vector<uint8_t>(10, 20));
+            ofxTestEq(cache.size(), 15, "IndexRangeCache::insert() evict");
+            ofxTestEq(cache.lookup({ 5, 3 }).pieces.size(), 0, "IndexRangeCache::insert() evict");
+            ofxTestEq(cache.lookup({ 0, 3 }).pieces.size(), 1, "IndexRangeCache::insert() evict");
+        }
+
+        {
+            std::size_t numThreads = ofx::IndexRangeParallel::numThreads();
+            ofx::IndexRangeParallel::setNumThreads(4);
+
+            RangeList list;
+            list.add({ 0, 100000 });
+            for (std::size_t i = 0; i < 100; ++i)
+                list.add({ 200000 + i * 10, 2 });
+
+            std::vector<std::atomic<int>> hits(list.back().getMax());
+            std::atomic<std::size_t> total(0);
+            std::atomic<std::size_t> largest(0);
+            std::atomic<bool> ranked(true);
+
+            list.forEachParallel([&](const Range& range, std::size_t rank) {
+                if (list.rank(range.location) != rank)
+                    ranked = false;
+
+                for (std::size_t i = range.getMin(); i < range.getMax(); ++i)
+                    ++hits[i];
+
+                total += range.size;
+
+                std::size_t size = largest;
+                while (range.size > size && !largest.compare_exchange_weak(size, range.size));
+            }, 1000);
+
+            bool once = true;
+            for (std::size_t i = 0; i < hits.size(); ++i)
+                once = once && hits[i] == (list.contains(i) ? 1 : 0);
+
+            ofxTestEq(total, list.cardinality(), "IndexRangeList::forEachParallel()");
+            ofxTestEq(once, true, "IndexRangeList::forEachParallel()");
+            ofxTestEq(ranked, true, "IndexRangeList::forEachParallel() rank");
+            ofxTestEq(largest < 100000, true, "IndexRangeList::forEachParallel() split");
+
+            ofx::IndexRangeParallel::setNumThreads(numThreads);
+        }
+
+        {
+            std::size_t numThreads = ofx::IndexRangeParallel::numThreads();
+            ofx::IndexRangeParallel::setNumThreads(4);
+
+            // Threads are reused across calls.
+            std::mutex mutex;
+            std::set<std::thread::id> ids;
+
+            for (std::size_t i = 0; i < 100; ++i)
+            {
+                ofx::IndexRangeParallel::forEach(16, [&](std::size_t) {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ids.insert(std::this_thread::get_id());
+                });
+            }
+
+            ofxTestEq(ids.size() <= 4, true, "IndexRangeParallel::forEach() pool");
+
+            std::atomic<std::size_t> count(0);
+            std::string message;
+
+            try
+            {
+                ofx::IndexRangeParallel::forEach(1000, [&](std::size_t i) {
+                    ++count;
+
+                    if (i == 10)
+                        throw std::runtime_error("task 10");
+                });
+            }
+            catch (const std::runtime_error& error)
+            {
+                message = error.what();
+            }
+
+            ofxTestEq(message, "task 10", "IndexRangeParallel::forEach() exception");
+
+            // The pool still works after an exception.
+            count = 0;
+            ofx::IndexRangeParallel::forEach(1000, [&](std::size_t) { ++count; });
+            ofxTestEq(count, 1000, "IndexRangeParallel::forEach()");
+
+            ofx::IndexRangeParallel::setNumThreads(numThreads);
+        }
+
+        {
+            // A new list takes the in-order append path, like a cleared one.
+            RangeList fresh;
+            RangeList cleared({ { 100, 1 } });
+            cleared.clear();
+
+            for (std::size_t i = 0; i < 10; ++i)
+            {
+                fresh.add({ i * 5, 8 });
+                cleared.add({ i * 5, 8 });
+            }
+
+            fresh.add({ 100, 10 });
+            cleared.add({ 100, 10 });
+
+            ofxTestEq(fresh.size(), 2, "IndexRangeList::add() append");
+            ofxTestEq(fresh.ranges()[0], Range(0, 53), "IndexRangeList::add() append");
+            ofxTestEq(fresh.cardinality(), 63, "IndexRangeList::add() append");
+            ofxTestEq(fresh.hash(), cleared.hash(), "IndexRangeList::add() append");
+            ofxTestEq(fresh == cleared, true, "IndexRangeList::add() append");
+        }
+
+        {
+            RangeList a;
+            a.add({ 0, 10 });
+            a.add({ 20, 10 });
+            a.add({ 40, 10 });
+
+            RangeList b;
+            b.add({ 40, 10 });
+            b.add({ 0, 5 });
+            b.add({ 20, 10 });
+            b.add({ 5, 5 });
+            ofxTestEq(a.hash(), b.hash(), "IndexRangeList::hash()");
+
+            a.remove({ 22, 3 });
+            ofxTestEq(a == b, false, "IndexRangeList::hash() remove");
+            b.remove({ 22, 3 });
+            ofxTestEq(a.hash(), b.hash(), "IndexRangeList::hash() remove");
+
+            a.insert({ 5, 7 });
+            b.insert({ 5, 7 });
+            ofxTestEq(a.hash(), b.hash(), "IndexRangeList::hash() insert");
+            ofxTestEq(a == b, true, "IndexRangeList::hash() insert");
+
+            std::unordered_map<RangeList, int> map;
+            map[a] = 1;
+            ofxTestEq(map.count(b), 1, "std::hash<IndexRangeList>");
+        }
+
+        {
+            RangeList a;
+            RangeList b;
+            for (std::size_t i = 0; i < 1000; ++i)
+            {
+                a.add({ i * 10, 5 });
+                b.add({ i * 20 + 3, 10 });
+            }
+
+            ofx::CompressedIndexRangeList ca(a);
+            ofx::CompressedIndexRangeList cb(b);
+            ofxTestEq(ca.size(), a.size(), "CompressedIndexRangeList::size()");
+            ofxTestEq(ca.cardinality(), a.cardinality(), "CompressedIndexRangeList::cardinality()");
+            ofxTestEq(ca.numBlocks(), 7, "CompressedIndexRangeList::numBlocks()");
+            ofxTestEq(ca.toList() == a, true, "CompressedIndexRangeList::toList()");
+            ofxTestEq(ca.sizeInBytes() * 4 < a.size() * sizeof(Range), true, "CompressedIndexRangeList::sizeInBytes()");
+
+            ofxTestEq(ca.contains(5004), true, "CompressedIndexRangeList::contains()");
+            ofxTestEq(ca.contains(5005), false, "CompressedIndexRangeList::contains()");
+            ofxTestEq(ca.lowerBound(5005), Range(5010, 5), "CompressedIndexRangeList::lowerBound()");
+            ofxTestEq(ca.lowerBound(99999), Range(Range::MAX, 0), "CompressedIndexRangeList::lowerBound()");
+
+            ofxTestEq(ca.unionWith(cb).toList() == a.unionWith(b), true, "CompressedIndexRangeList::unionWith()");
+            ofxTestEq(ca.intersectionWith(cb).toList() == a.intersectionWith(b), true, "CompressedIndexRangeList::intersectionWith()");
+            ofxTestEq(ca.differenceWith(cb).toList() == a.differenceWith(b), true, "CompressedIndexRangeList::differenceWith()");
+
+            ofx::CompressedIndexRangeList appended;
+            ofxTestEq(appended.append({ 10, 5 }), true, "CompressedIndexRangeList::append()");
+            ofxTestEq(appended.append({ 15, 5 }), true, "CompressedIndexRangeList::append() merge");
+            ofxTestEq(appended.append({ 0, 5 }), false, "CompressedIndexRangeList::append() order");
+            ofxTestEq(appended.size(), 1, "CompressedIndexRangeList::append()");
+            ofxTestEq(appended.cardinality(), 10, "CompressedIndexRangeList::append()");
+        }
+
     }
 
 };